@@ -1,4 +1,5 @@
 import sys
+import re
 from threading import Lock
 import cv2
 import numpy as np
@@ -75,6 +76,7 @@ class YarpMdetr(yarp.RFModule):
         self.model.eval()
         
         self.caption = ''  
+        self.targets = []
         self.lock = Lock() 
 
         return True
@@ -82,12 +84,17 @@ class YarpMdetr(yarp.RFModule):
     def respond(self, command, reply):
         if command.get(0).asString() == 'label':
             print('Command \'label\' received')
-            self.caption = command.get(1).asString()
+            self.lock.acquire()
+            #several objects are looked for with a single caption, each box is then labeled with the object it matches
+            self.targets = [command.get(i).asString() for i in range(1, command.size())]
+            self.caption = '. '.join(self.targets)
+            self.lock.release()
             reply.addString('labeling: ' + self.caption)
         elif command.get(0).asString() == 'where':
             print('Command \'where\' received')
             self.lock.acquire()
             self.caption = command.get(1).asString()
+            self.targets = [self.caption]
             self.plot_inference(self._in_buf_array, self.caption)
             bt=self.read_coords_port.read()
             if bt.check(self.caption):
@@ -98,7 +105,7 @@ class YarpMdetr(yarp.RFModule):
         elif command.get(0).asString() == 'help':
             print('Command \'help\' received')
             reply.addVocab32('many')
-            reply.addString('label <something> : identify "something" in input image')
+            reply.addString('label <something> [<something else> ...] : identify "something" in input image')
             reply.addString('where <something> : returns whether "something" is found in the input image')
             reply.addString('help : get this list')           
         else:
@@ -153,6 +160,28 @@ class YarpMdetr(yarp.RFModule):
         return np.array(pil_img)
          
 
+    @staticmethod
+    def words(text):
+        #whole words only, so that "cup" does not match "cupboard", and without the articles, which match anything
+        return [w for w in re.findall(r'\w+', text.lower()) if w not in ('a', 'an', 'the')]
+
+    def box_target(self, span):
+        #with a single object the whole caption is the label, otherwise the object whose words were predicted for the box:
+        # the first one named whole in the span, else the one sharing most words with it
+        if len(self.targets) > 1:
+            span_words = set(self.words(span))
+            best, best_shared = None, 0
+            for target in self.targets:
+                target_words = self.words(target)
+                shared = len(span_words.intersection(target_words))
+                if shared > 0 and shared == len(set(target_words)):
+                    return target
+                if shared > best_shared:
+                    best, best_shared = target, shared
+            if best is not None:
+                return best
+        return self.caption
+
     def plot_inference(self, im, caption):
         im = Image.fromarray(im)
         img = self.transform(im).unsqueeze(0).cuda()
@@ -182,7 +211,7 @@ class YarpMdetr(yarp.RFModule):
                 x_out=x.item() * self.image_w
                 y_out=y.item() * self.image_h
                 b = bout.addList()
-                b.addString(self.caption)
+                b.addString(self.box_target(predicted_spans[idx]))
                 b.addFloat32(float(probs_bbox[idx]))
                 b.addFloat32(x_out)
                 b.addFloat32(y_out)
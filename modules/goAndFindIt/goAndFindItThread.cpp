@@ -39,6 +39,9 @@ GoAndFindItThread::GoAndFindItThread(yarp::os::ResourceFinder &rf) :
     m_max_nav_time          = 300.0;
     m_max_search_time       = 120.0;
     m_setNavPos_time        = 3.0;
+    m_client_id             = "";
+    m_heartbeat_period      = 5.0;
+    m_last_heartbeat        = 0.0;
 }
 
 /****************************************************************/
@@ -51,6 +54,10 @@ bool GoAndFindItThread::threadInit()
         m_max_search_time = m_rf.find("max_search_time").asFloat32();
     if(m_rf.check("set_nav_pos_time"))
         m_setNavPos_time = m_rf.find("set_nav_pos_time").asFloat32();
+    if(m_rf.check("client_id"))
+        m_client_id = m_rf.find("client_id").asString();
+    if(m_rf.check("heartbeat_period"))
+        m_heartbeat_period = m_rf.find("heartbeat_period").asFloat32();
 
     //Open ports
     if(m_rf.check("nextLoc_rpc_port"))
@@ -222,6 +229,9 @@ void GoAndFindItThread::run()
             break;
         }
 
+        if (m_status == GaFI_SEARCHING)
+            heartbeat();
+
         Time::delay(0.2);
 
     }
@@ -300,6 +310,26 @@ void GoAndFindItThread::nextWhere()
 {
     Bottle request,reply;
     request.addString("next");
+    request.addString(m_what);  //the planner starts from where the object has been found before
+    if (m_client_id != "")
+    {
+        //the location is reserved for this robot, as long as heartbeats are sent
+        request.addString("client");
+        request.addString(m_client_id);
+        m_last_heartbeat = Time::now();
+
+        //the planner ranks from its own localization: the location is chosen from where this robot is
+        Nav2D::Map2DLocation pose;
+        if (m_iNav2D->getCurrentPosition(pose))
+        {
+            request.addString("pose");
+            Bottle& poseList = request.addList();
+            poseList.addFloat64(pose.x);
+            poseList.addFloat64(pose.y);
+            poseList.addFloat64(pose.theta);
+            poseList.addString(pose.map_id);
+        }
+    }
     if(m_nextLoc_rpc_port.write(request,reply))
     {
         string loc = reply.get(0).asString(); 
@@ -323,6 +353,20 @@ void GoAndFindItThread::nextWhere()
 }
 
 
+/****************************************************************/
+void GoAndFindItThread::heartbeat()
+{
+    if (m_client_id == "" || Time::now() - m_last_heartbeat < m_heartbeat_period)
+        return;
+
+    Bottle request,reply;
+    request.addString("heartbeat");
+    request.addString(m_client_id);
+    m_nextLoc_rpc_port.write(request,reply);
+    m_last_heartbeat = Time::now();
+}
+
+
 /****************************************************************/
 bool GoAndFindItThread::setNavigationPosition()
 {
@@ -376,29 +420,52 @@ bool GoAndFindItThread::goThere()
         return false; //possible external stop during setNavigationPosition
 
     //navigating to "m_where"
-    m_iNav2D->gotoTargetByLocationName(m_where);
+    if (!m_iNav2D->gotoTargetByLocationName(m_where))
+    {
+        yCError(GO_AND_FIND_IT_THREAD,"The navigation server did not accept the goal %s",m_where.c_str());
+        locationNotReached(false);
+        return false;
+    }
     yCInfo(GO_AND_FIND_IT_THREAD, "Going to location %s", m_where.c_str());
 
     Nav2D::NavigationStatusEnum currentStatus;
-    m_iNav2D->getNavigationStatus(currentStatus);
+    bool statusOk = m_iNav2D->getNavigationStatus(currentStatus);
     double toomuchtime = Time::now() + m_max_nav_time; //five minutes to reach "m_where"
 
     while (currentStatus != Nav2D::navigation_status_goal_reached)
     {
-        if (currentStatus == Nav2D::navigation_status_aborted || m_status != GaFI_NAVIGATING)
+        if (m_status != GaFI_NAVIGATING)
         {
             yCWarning(GO_AND_FIND_IT_THREAD,"Navigation has been interrupted. Location not reached.");
             m_status = GaFI_IDLE;
             return false;
         }
 
+        if (!statusOk)
+        {
+            yCError(GO_AND_FIND_IT_THREAD,"Cannot read the navigation status. Location %s not reached.",m_where.c_str());
+            m_iNav2D->stopNavigation();
+            locationNotReached(false);
+            return false;
+        }
+
+        if (currentStatus == Nav2D::navigation_status_aborted)
+        {
+            yCWarning(GO_AND_FIND_IT_THREAD,"Navigation to %s aborted. Location not reached.",m_where.c_str());
+            locationNotReached(navigationHealthy());
+            return false;
+        }
+
         if (Time::now() > toomuchtime)
         {
             yCError(GO_AND_FIND_IT_THREAD,"Too much time has passed to navigate to %s.",m_where.c_str());
-            stopSearch();
+            m_iNav2D->stopNavigation();
+            locationNotReached(navigationHealthy());
+            return false;
         }
         Time::delay(0.2);
-        m_iNav2D->getNavigationStatus(currentStatus);
+        heartbeat();
+        statusOk = m_iNav2D->getNavigationStatus(currentStatus);
         
     }
     m_status = GaFI_ARRIVED;
@@ -407,6 +474,51 @@ bool GoAndFindItThread::goThere()
     return true;
 }
 
+/****************************************************************/
+bool GoAndFindItThread::navigationHealthy()
+{
+    //an abort is blamed on the location only if the navigation server and the localization still answer
+    Nav2D::NavigationStatusEnum status;
+    Nav2D::Map2DLocation pose;
+    return m_iNav2D->getNavigationStatus(status) && m_iNav2D->getCurrentPosition(pose);
+}
+
+/****************************************************************/
+void GoAndFindItThread::locationNotReached(bool blockLocation)
+{
+    Bottle request,_rep_;
+    if (blockLocation)
+    {
+        //the planner skips the location for a while, so that this and the next searches do not get stuck on it
+        request.fromString("set " + m_where + " blocked");
+    }
+    else
+    {
+        //the navigation itself is failing: the location is not to blame and is given back to the planner
+        yCError(GO_AND_FIND_IT_THREAD,"Navigation not available: %s is not set as blocked",m_where.c_str());
+        request.fromString("set " + m_where + " unchecked");
+    }
+    m_nextLoc_rpc_port.write(request,_rep_);
+
+    if (m_where_specified || !blockLocation)
+    {
+        yCInfo(GO_AND_FIND_IT_THREAD,"%s not reached. Terminating search.", m_where.c_str());
+        Bottle&  toSend = m_output_port.prepare();
+        toSend.clear();
+        toSend.addString("not reached");    //Search failed before looking
+        toSend.addString(m_where);
+        m_output_port.write();
+
+        m_status = GaFI_IDLE;
+        m_in_nav_position = false;
+    }
+    else
+    {
+        yCInfo(GO_AND_FIND_IT_THREAD,"Moving on to the next location");
+        m_status = GaFI_NEW_SEARCH;
+    }
+}
+
 /****************************************************************/
 bool GoAndFindItThread::search()
 {
@@ -456,7 +568,10 @@ bool GoAndFindItThread::objFound()
     
     
     Bottle request,_rep_;
-    request.fromString("set " + m_where + " checked");
+    request.addString("set");
+    request.addString(m_where);
+    request.addString("checked");
+    request.addString(m_what);  //let the planner record where the object has been found
     m_nextLoc_rpc_port.write(request,_rep_);
 
     m_in_nav_position = false;
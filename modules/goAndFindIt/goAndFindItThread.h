@@ -78,6 +78,11 @@ private:
     bool                    m_in_nav_position;
     double                  m_setNavPos_time;
 
+    //Lease on the location, when several robots share the same nextLocPlanner
+    string                  m_client_id;
+    double                  m_heartbeat_period;
+    double                  m_last_heartbeat;
+
 public:
     //Contructor and distructor
     GoAndFindItThread(ResourceFinder &rf);
@@ -97,8 +102,11 @@ public:
     void setWhat(string& what);
     void setWhatWhere(string& what, string& where);
     void nextWhere();
+    void heartbeat();
     bool setNavigationPosition();
     bool goThere();
+    bool navigationHealthy();
+    void locationNotReached(bool blockLocation);
     bool search();
     bool objFound();
     bool objNotFound();
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "detectionCallback.h"
+
+YARP_LOG_COMPONENT(DETECTION_CALLBACK, "r1_obr.lookForObject.DetectionCallback")
+
+
+/****************************************************************/
+DetectionCallback::DetectionCallback(yarp::os::BufferedPort<yarp::os::Bottle>& port):
+    TypedReaderCallback(),
+    m_port(port),
+    m_latency(0.3),
+    m_last_frame(0.0)
+{
+}
+
+/****************************************************************/
+void DetectionCallback::onRead(yarp::os::Bottle& b)
+{
+    //detections without an image timestamp are dated back by the detector latency
+    yarp::os::Stamp stamp;
+    m_port.getEnvelope(stamp);
+    double frameTime = stamp.isValid() ? stamp.getTime() : yarp::os::Time::now() - m_latency;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_last_frame = frameTime;
+    m_last_bottle = b;
+    if (m_targets.empty())
+    {
+        m_cv.notify_all();
+        return;
+    }
+
+    //one pass on the frame: the most confident detection of each target
+    std::map<std::string, Detection> seen;
+    for (size_t i=0; i<b.size(); i++)
+    {
+        yarp::os::Bottle* obj = b.get(i).asList();
+        if (!obj || m_targets.find(obj->get(0).asString()) == m_targets.end()) //skip objects with another label
+            continue;
+
+        auto it = seen.find(obj->get(0).asString());
+        if (it == seen.end() || obj->get(1).asFloat32() > it->second.conf)
+        {
+            Detection& det = seen[obj->get(0).asString()];
+            det.conf = obj->get(1).asFloat32();
+            det.x = obj->get(2).asFloat32();
+            det.y = obj->get(3).asFloat32();
+            det.stamp = frameTime;
+        }
+    }
+
+    for (auto& t : m_targets)
+    {
+        auto it = seen.find(t.first);
+        if (it == seen.end())
+        {
+            t.second.hits = 0;
+            continue;
+        }
+        t.second.last = it->second;
+        t.second.has_hit = true;
+        t.second.hits++;
+        yCDebug(DETECTION_CALLBACK, "%s detected (%d frames in a row)", t.first.c_str(), t.second.hits);
+    }
+    m_cv.notify_all();
+}
+
+/****************************************************************/
+void DetectionCallback::setLatency(double latency)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_latency = latency;
+}
+
+/****************************************************************/
+void DetectionCallback::arm(const std::vector<std::string>& targets)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_targets.clear();
+    for (auto& t : targets)
+        m_targets[t] = Target();
+}
+
+/****************************************************************/
+void DetectionCallback::remove(const std::string& target)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_targets.erase(target);
+}
+
+/****************************************************************/
+void DetectionCallback::disarm()
+{
+    arm({});
+}
+
+/****************************************************************/
+bool DetectionCallback::hits(int n, std::string& label, Detection& last, double after)
+{
+    //only the detections from images taken after <after> count
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& t : m_targets)
+    {
+        if (t.second.hits >= n && t.second.last.stamp > after)
+        {
+            label = t.first;
+            last = t.second.last;
+            return true;
+        }
+    }
+    return false;
+}
+
+/****************************************************************/
+bool DetectionCallback::lastHit(const std::string& label, Detection& last)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_targets.find(label);
+    if (it == m_targets.end() || !it->second.has_hit)
+        return false;
+    last = it->second.last;
+    return true;
+}
+
+/****************************************************************/
+bool DetectionCallback::lastFrame(yarp::os::Bottle& b, double& stamp)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_last_frame <= 0.0)
+        return false;
+    b = m_last_bottle;
+    stamp = m_last_frame;
+    return true;
+}
+
+/****************************************************************/
+bool DetectionCallback::waitFrame(double after, double timeout, const std::atomic<bool>& stop)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    //a hit from an older image does not end the wait: its pixels may not match the current head pose
+    m_cv.wait_for(lock, std::chrono::duration<double>(timeout), [&]() { return m_last_frame > after || stop; });
+    return m_last_frame > after;
+}
+
+/****************************************************************/
+void DetectionCallback::wakeUp()
+{
+    //lets the waits check the cancellation of the search
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cv.notify_all();
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef DETECTION_CALLBACK_H
+#define DETECTION_CALLBACK_H
+
+#include <yarp/os/all.h>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <string>
+#include <vector>
+#include <map>
+
+struct Detection
+{
+    double  conf {0.0};
+    double  x {-1.0};
+    double  y {-1.0};
+    double  stamp {0.0};    //time of the image the detection comes from
+};
+
+/**
+ * Callback of the object finder detections port.
+ * Every incoming frame is matched against all the target labels at once, as soon as it arrives:
+ * for each target it counts the consecutive frames in which it is seen and keeps the most confident detection of the last one.
+ */
+class DetectionCallback : public yarp::os::TypedReaderCallback<yarp::os::Bottle>
+{
+private:
+    struct Target
+    {
+        int         hits {0};
+        bool        has_hit {false};
+        Detection   last;
+    };
+
+    yarp::os::BufferedPort<yarp::os::Bottle>&   m_port;
+    std::mutex                                  m_mutex;
+    std::condition_variable                     m_cv;
+    std::map<std::string, Target>               m_targets;
+    double                                      m_latency;
+    double                                      m_last_frame;
+    yarp::os::Bottle                            m_last_bottle;
+
+public:
+    DetectionCallback(yarp::os::BufferedPort<yarp::os::Bottle>& port);
+    ~DetectionCallback() = default;
+
+    using TypedReaderCallback<yarp::os::Bottle>::onRead;
+    void onRead(yarp::os::Bottle& b) override;
+
+    void setLatency(double latency);
+    void arm(const std::vector<std::string>& targets);
+    void remove(const std::string& target);
+    void disarm();
+    bool hits(int n, std::string& label, Detection& last, double after = 0.0);
+    bool lastHit(const std::string& label, Detection& last);
+    bool lastFrame(yarp::os::Bottle& b, double& stamp);
+    bool waitFrame(double after, double timeout, const std::atomic<bool>& stop);
+    void wakeUp();
+};
+
+#endif
@@ -24,8 +24,10 @@ YARP_LOG_COMPONENT(LOOK_FOR_OBJECT_THREAD, "r1_obr.lookForObject.LookForObjectTh
 /****************************************************************/
 LookForObjectThread::LookForObjectThread(yarp::os::ResourceFinder &rf):
     TypedReaderCallback(),
+    m_detections(m_objectCoordsPort),
     m_rf(rf),
     m_ext_stop(false),
+    m_stop_thread(false),
     m_status(LfO_IDLE)
 {
     //Defaults
@@ -34,7 +36,19 @@ LookForObjectThread::LookForObjectThread(yarp::os::ResourceFinder &rf):
     m_gazeTargetOutPortName = "/lookForObject/gazeControllerTarget:o";
     m_objectCoordsPortName = "/lookForObject/objectCoordinates:i";
     m_wait_for_search = 4.0;
-    m_object = "";
+    m_frame_grace = 0.5;
+    m_sweep = false;
+    m_confirm_frames = 2;
+    m_detector_latency = 0.3;
+    m_gaze_found = false;
+    m_new_search = false;
+    m_closed_loop_turn = false;
+    m_turn_tolerance = 3.0;
+    m_turn_gain = 1.5;
+    m_turn_max_speed = 30.0;
+    m_turn_min_speed = 5.0;
+    m_turn_timeout = 15.0;
+    m_objects.clear();
 }
 
 /****************************************************************/
@@ -54,6 +68,16 @@ bool LookForObjectThread::threadInit()
     }
     
     if (m_rf.check("wait_for_search")) {m_wait_for_search = m_rf.find("wait_for_search").asFloat32();}
+    if (m_rf.check("frame_grace")) {m_frame_grace = m_rf.find("frame_grace").asFloat32();}
+    if (m_rf.check("sweep_mode")) {m_sweep = m_rf.find("sweep_mode").asString() == "true";}
+    if (m_rf.check("sweep_confirm_frames")) {m_confirm_frames = m_rf.find("sweep_confirm_frames").asInt32();}
+    if (m_rf.check("detector_latency")) {m_detector_latency = m_rf.find("detector_latency").asFloat32();}
+    if (m_rf.check("closed_loop_turn")) {m_closed_loop_turn = m_rf.find("closed_loop_turn").asString() == "true";}
+    if (m_rf.check("turn_tolerance")) {m_turn_tolerance = m_rf.find("turn_tolerance").asFloat32();}
+    if (m_rf.check("turn_gain")) {m_turn_gain = m_rf.find("turn_gain").asFloat32();}
+    if (m_rf.check("turn_max_speed")) {m_turn_max_speed = m_rf.find("turn_max_speed").asFloat32();}
+    if (m_rf.check("turn_min_speed")) {m_turn_min_speed = m_rf.find("turn_min_speed").asFloat32();}
+    if (m_rf.check("turn_timeout")) {m_turn_timeout = m_rf.find("turn_timeout").asFloat32();}
     
     // --------- Navigation2DClient config --------- //
     yarp::os::Property nav2DProp;
@@ -108,6 +132,8 @@ bool LookForObjectThread::threadInit()
         yCError(LOOK_FOR_OBJECT_THREAD) << "Cannot open port with name" << m_objectCoordsPortName;
         return false;
     }
+    m_detections.setLatency(m_detector_latency);
+    m_objectCoordsPort.useCallback(m_detections);
     
 
     return true;
@@ -140,12 +166,41 @@ void LookForObjectThread::threadRelease()
 /****************************************************************/
 void LookForObjectThread::run()
 {
+    //m_status is only written by this thread: the port callbacks queue requests and raise m_ext_stop
     while (true)
     {
+        //sleep until there is something to do: a new request always preempts the current state
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_stop_thread || !m_requests.empty() || m_status != LfO_IDLE; });
+            if (m_stop_thread)
+                break;
+
+            if (!m_requests.empty())
+            {
+                //only the latest request matters: the previous ones have been preempted
+                yarp::os::Bottle request = m_requests.back();
+                m_requests.clear();
+                m_ext_stop = false;
+                newSearch(request);
+            }
+        }
 
         if (m_status == LfO_SEARCHING)
         {
-            lookAround(m_object);   
+            bool recalled {false};
+            if (m_new_search)
+            {
+                m_new_search = false;
+                recalled = startSearch();
+            }
+
+            if (recalled)
+                m_status = LfO_OBJECT_FOUND;
+            else if (m_sweep)
+                sweep();
+            else
+                lookAround();   
         }
 
         else if (m_status == LfO_TURNING)
@@ -163,18 +218,16 @@ void LookForObjectThread::run()
             writeResult(false);
         } 
 
-        else if (m_status == LfO_IDLE)
-        {
-            Time::delay(0.8);
-        }
-
-        else if (m_status == LfO_STOP)
+        //a cancelled search goes back to idle, unless a new request is already waiting
         {
-            break;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_ext_stop && m_requests.empty())
+            {
+                if (m_status != LfO_IDLE)
+                    m_detections.disarm();
+                m_status = LfO_IDLE;
+            }
         }
-
-        Time::delay(0.2);
-
     }
 }
 
@@ -191,15 +244,10 @@ void LookForObjectThread::onRead(yarp::os::Bottle &b)
     {
         std::string obj {b.get(0).asString()};
         
-        if(b.size() > 1)
+        if(b.size() > 1 && obj=="label")
         {
-            if (obj=="label")
-            {
-                m_findObjectPort.write(b);
-                return;
-            }
-            else
-                yCWarning(LOOK_FOR_OBJECT_THREAD,"The input bottle has the wrong number of elements. Using only the first element.");
+            m_findObjectPort.write(b);
+            return;
         }
         
         if (obj=="stop") 
@@ -212,79 +260,105 @@ void LookForObjectThread::onRead(yarp::os::Bottle &b)
         }
         else
         {
-            if (m_status == LfO_SEARCHING)
+            //queued for the thread, cancelling the running search if any: the port is not blocked
             {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_requests.push_back(b);
                 m_ext_stop = true;
-                yarp::os::Time::delay(m_wait_for_search + 0.25); 
             }
-            m_ext_stop = false;
-            m_robotOrient->resetTurns();
-            m_object = obj;
-            m_status = LfO_SEARCHING;
+            m_cv.notify_all();
+            m_detections.wakeUp();
         }
         
     }
 }
 
+/****************************************************************/
+void LookForObjectThread::newSearch(const yarp::os::Bottle& request)
+{
+    m_robotOrient->resetTurns();
+    m_new_search = true;
+    m_objects.clear();
+    for (size_t i=0; i<request.size(); i++)     //several objects can be searched in the same scan
+    {
+        if (std::find(m_objects.begin(), m_objects.end(), request.get(i).asString()) == m_objects.end())
+            m_objects.push_back(request.get(i).asString());
+    }
+    m_gaze_found = false;
+    m_status = LfO_SEARCHING;
+}
+
+/****************************************************************/
+bool LookForObjectThread::waitCancelled(double timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_cv.wait_for(lock, std::chrono::duration<double>(timeout), [this]() { return m_ext_stop.load(); });
+}
+
+/****************************************************************/
+double LookForObjectThread::frameBudget(double deadline) const
+{
+    //a pose that used up its time settling still gets a frame
+    return std::max(m_frame_grace, deadline - yarp::os::Time::now());
+}
+
 /****************************************************************/
 void LookForObjectThread::onStop()
 {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop_thread = true;
+    }
     externalStop();
-    m_status =LfO_STOP;
 }
 
 
 /****************************************************************/
-bool LookForObjectThread::lookAround(std::string& ob)
+bool LookForObjectThread::lookAround()
 {
     m_robotOrient->resetOrients();
+    m_detections.arm(m_objects);
+
+    //the detections are evaluated as they arrive: a match interrupts the wait even while the head is still moving,
+    // but a moving head blurs the image, so it has to be confirmed by several frames
+    std::string label;
+    Detection hit;
+    auto matched = [this, &label, &hit]() { m_robotOrient->recordHead(); return m_ext_stop || m_detections.hits(m_confirm_frames, label, hit); };
 
-    bool objectFound {false};
+    bool allFound {false};
     int idx {1};
-    while (!m_ext_stop)
+    while (!m_ext_stop && !allFound)
     {
         //retrieve next head orientation
         Bottle replyOrient;
         if (m_robotOrient->next(replyOrient))
         {                        
             yCInfo(LOOK_FOR_OBJECT_THREAD) << "Checking head orientation: pos" + (std::string)(idx<10?"0":"") + std::to_string(idx);
-            //gaze target output
-            yarp::os::Bottle&  toSend1 = m_gazeTargetOutPort.prepare();
-            toSend1.clear();
-            yarp::os::Bottle& targetTypeList = toSend1.addList();
-            targetTypeList.addString("target-type");
-            targetTypeList.addString("angular");
-            yarp::os::Bottle& targetLocationList = toSend1.addList();
-            targetLocationList.addString("target-location");
-            yarp::os::Bottle& targetList1 = targetLocationList.addList();
             yarp::os::Bottle* tmpBottle = replyOrient.get(0).asList();
-            targetList1.addFloat32(tmpBottle->get(0).asFloat32());
-            targetList1.addFloat32(tmpBottle->get(1).asFloat32());
-            m_gazeTargetOutPort.write(); //sending output command to gaze-controller 
-
-            yarp::os::Time::delay(m_wait_for_search);  //waiting for the robot tilting its head
-
-            //search for object
-            Bottle request, reply;
-            request.addString("where");
-            request.addString(ob); 
-            yCDebug(LOOK_FOR_OBJECT_THREAD, "Request to object finder: %s", request.toString().c_str());
-            if (m_findObjectPort.write(request,reply))
+            sendGazeTarget(tmpBottle->get(0).asFloat32(), tmpBottle->get(1).asFloat32());
+
+            //waiting for the robot tilting its head, reporting the objects seen meanwhile
+            // (wait_for_search bounds the whole time spent on the pose, frame included)
+            double pan = tmpBottle->get(0).asFloat32(), tilt = tmpBottle->get(1).asFloat32();
+            double deadline = yarp::os::Time::now() + m_wait_for_search;
+            RobotOrient::SettleResult settle {RobotOrient::SETTLE_STOPPED};
+            while (settle == RobotOrient::SETTLE_STOPPED && !m_ext_stop && !allFound)
             {
-                if (reply.get(0).asString()!="not found")
-                {
-                    objectFound = true;
-                    break;
-                }
+                double left = deadline - yarp::os::Time::now();
+                settle = left > 0 ? m_robotOrient->waitSettled(left, matched) : RobotOrient::SETTLE_TIMEOUT;
+                allFound = reportHits(m_confirm_frames);
             }
-            else
+
+            //then waiting for the detections of a frame taken with the head still: a single one is enough.
+            // If the head did not settle in time, the frame is still given frame_grace seconds
+            m_robotOrient->recordHead();
+            if (!m_ext_stop && !allFound && m_detections.waitFrame(m_robotOrient->settledAt(), frameBudget(deadline), m_ext_stop))
             {
-                yCError(LOOK_FOR_OBJECT_THREAD,"Unable to communicate with findObject");
+                rememberView(pan, tilt, m_robotOrient->settledAt());
+                allFound = reportHits(1, m_robotOrient->settledAt());
             }
 
             idx++;
-
-            yarp::os::Time::delay(0.2);
         }
         else
         {
@@ -295,7 +369,7 @@ bool LookForObjectThread::lookAround(std::string& ob)
     
 
     
-    if (objectFound)
+    if (allFound)
         m_status = LfO_OBJECT_FOUND;
     else if (!m_ext_stop)
         m_status = LfO_TURNING;
@@ -304,6 +378,179 @@ bool LookForObjectThread::lookAround(std::string& ob)
 }
 
 
+/****************************************************************/
+bool LookForObjectThread::sweep()
+{
+    m_robotOrient->resetOrients();
+    std::vector<RobotOrient::SweepRow> rows;
+    m_robotOrient->sweepRows(rows);
+    double speed = m_robotOrient->sweepSpeed();
+    auto cancelled = [this]() { return m_ext_stop.load(); };
+
+    bool allFound {false};
+    double lastStamp {yarp::os::Time::now()};
+    for (size_t r=0; r<rows.size() && !allFound && !m_ext_stop; r++)
+    {
+        const RobotOrient::SweepRow& row = rows[r];
+        yCInfo(LOOK_FOR_OBJECT_THREAD, "Sweeping from %.1f to %.1f degrees at tilt %.1f (%.1f deg/s)", row.from, row.to, row.tilt, speed);
+        sendGazeTarget(row.from, row.tilt);
+        m_robotOrient->waitSettled(m_wait_for_search, cancelled);
+        m_detections.arm(m_objects);
+
+        //stream intermediate targets, so that the head moves at the sweep speed,
+        // and keep going for the detector latency once the end of the row is reached
+        double duration = fabs(row.to - row.from) / speed;
+        double t0 = yarp::os::Time::now();
+        while (!m_ext_stop && !allFound)
+        {
+            double t = yarp::os::Time::now() - t0;
+            double k = duration > 0.0 ? std::min(1.0, t / duration) : 1.0;
+            sendGazeTarget(row.from + k * (row.to - row.from), row.tilt);
+            m_robotOrient->recordHead();
+
+            yarp::os::Bottle frame;
+            double stamp, framePan, frameTilt;
+            if (m_detections.lastFrame(frame, stamp) && stamp > lastStamp && m_robotOrient->headAt(stamp, framePan, frameTilt))
+            {
+                m_robotOrient->remember(framePan, frameTilt, frame);
+                lastStamp = stamp;
+            }
+
+            std::string label;
+            Detection hit;
+            while (!allFound && m_detections.hits(m_confirm_frames, label, hit))
+            {
+                double headPan, headTilt;
+                if (!m_robotOrient->headAt(hit.stamp, headPan, headTilt))
+                {
+                    headPan = row.from + k * (row.to - row.from);
+                    headTilt = row.tilt;
+                }
+                m_robotOrient->pixelToGaze(hit.x, hit.y, headPan, headTilt, m_gaze_pan, m_gaze_tilt);
+                m_gaze_found = true;
+                yCInfo(LOOK_FOR_OBJECT_THREAD, "%s found at pan %.1f tilt %.1f", label.c_str(), m_gaze_pan, m_gaze_tilt);
+
+                if (m_objects.size() == 1)
+                {
+                    //bring the head where the last object was seen and wait for a detection from there, so that the pixel coordinates match the head pose:
+                    // if the object is not seen again in a frame taken with the head still, only the gaze angles are reported
+                    sendGazeTarget(m_gaze_pan, m_gaze_tilt);
+                    m_detections.arm(m_objects);
+                    Detection still;
+                    double deadline = yarp::os::Time::now() + m_wait_for_search;
+                    bool seen = m_robotOrient->waitSettled(m_wait_for_search, cancelled) != RobotOrient::SETTLE_STOPPED &&
+                                m_detections.waitFrame(m_robotOrient->settledAt(), frameBudget(deadline), m_ext_stop) &&
+                                m_detections.lastHit(label, still) && still.stamp > m_robotOrient->settledAt();
+                    hit = seen ? still : Detection();
+                    if (!seen)
+                        yCInfo(LOOK_FOR_OBJECT_THREAD, "%s not detected again with the head still: reporting the gaze angles only", label.c_str());
+                }
+                reportObject(label, hit);
+                allFound = m_objects.empty();
+            }
+
+            if (t > duration + m_detector_latency)
+                break;
+
+            if (waitCancelled(0.02))
+                break;
+        }
+    }
+
+    if (allFound)
+        m_status = LfO_OBJECT_FOUND;
+    else if (!m_ext_stop)
+    {
+        m_robotOrient->home();
+        m_status = LfO_TURNING;
+    }
+
+    return true;
+}
+
+/****************************************************************/
+bool LookForObjectThread::startSearch()
+{
+    //the object finder streams what it is told to look for: all the objects of the search go in a single label command
+    yarp::os::Bottle labelCmd, labelReply;
+    labelCmd.addString("label");
+    for (auto& ob : m_objects)
+        labelCmd.addString(ob);
+    if (!m_findObjectPort.write(labelCmd, labelReply))
+        yCError(LOOK_FOR_OBJECT_THREAD,"Unable to communicate with findObject");
+
+    yarp::dev::Nav2D::Map2DLocation loc;
+    if (!m_iNav2D->getCurrentPosition(loc))
+    {
+        yCWarning(LOOK_FOR_OBJECT_THREAD, "Cannot retrieve the robot position: turning by fixed angles and without scan memory");
+        return false;
+    }
+    m_robotOrient->setPose(loc.map_id, loc.x, loc.y, loc.theta);
+
+    if (m_robotOrient->scanPlanning())
+    {
+        yarp::dev::Nav2D::MapGrid2D map;
+        if (m_iNav2D->getCurrentNavigationMap(yarp::dev::Nav2D::NavigationMapTypeEnum::global_map, map))
+            m_robotOrient->planScan(map, loc.x, loc.y, loc.theta);
+        else
+            yCWarning(LOOK_FOR_OBJECT_THREAD, "Cannot retrieve the global map: turning by fixed angles");
+    }
+
+    //the objects seen here recently: look there first and confirm them with a new frame
+    auto cancelled = [this]() { return m_ext_stop.load(); };
+    std::vector<std::string> targets = m_objects;
+    for (auto& ob : targets)
+    {
+        double pan, tilt;
+        if (m_ext_stop || !m_robotOrient->recall(ob, pan, tilt))
+            continue;
+
+        yCInfo(LOOK_FOR_OBJECT_THREAD, "%s seen recently from here at pan %.1f tilt %.1f: checking it", ob.c_str(), pan, tilt);
+        sendGazeTarget(pan, tilt);
+        m_detections.arm({ob});
+        double deadline = yarp::os::Time::now() + m_wait_for_search;
+        if (m_robotOrient->waitSettled(m_wait_for_search, cancelled) != RobotOrient::SETTLE_STOPPED)
+            m_detections.waitFrame(m_robotOrient->settledAt(), frameBudget(deadline), m_ext_stop);
+        rememberView(pan, tilt, m_robotOrient->settledAt());
+
+        Detection hit;
+        if (!m_ext_stop && m_detections.lastHit(ob, hit))
+        {
+            m_gaze_pan = pan;
+            m_gaze_tilt = tilt;
+            m_gaze_found = true;
+            reportObject(ob, hit);
+        }
+    }
+
+    return m_objects.empty();
+}
+
+/****************************************************************/
+void LookForObjectThread::rememberView(double pan, double tilt, double after)
+{
+    yarp::os::Bottle frame;
+    double stamp;
+    if (m_detections.lastFrame(frame, stamp) && stamp > after)
+        m_robotOrient->remember(pan, tilt, frame);
+}
+
+/****************************************************************/
+void LookForObjectThread::sendGazeTarget(double pan, double tilt)
+{
+    yarp::os::Bottle&  toSend1 = m_gazeTargetOutPort.prepare();
+    toSend1.clear();
+    yarp::os::Bottle& targetTypeList = toSend1.addList();
+    targetTypeList.addString("target-type");
+    targetTypeList.addString("angular");
+    yarp::os::Bottle& targetLocationList = toSend1.addList();
+    targetLocationList.addString("target-location");
+    yarp::os::Bottle& targetList1 = targetLocationList.addList();
+    targetList1.addFloat32(pan);
+    targetList1.addFloat32(tilt);
+    m_gazeTargetOutPort.write(); //sending output command to gaze-controller 
+}
+
 /****************************************************************/
 bool LookForObjectThread::turn()
 {  
@@ -315,17 +562,14 @@ bool LookForObjectThread::turn()
     {
         double theta = reply.get(0).asFloat32();
         yCInfo(LOOK_FOR_OBJECT_THREAD) << "Turning" << theta << "degrees";
+        double t0 = yarp::os::Time::now();
+        bool ok = m_closed_loop_turn ? rotateInPlace(theta) : rotateByNavigation(theta);
+        if (ok)
+            yCInfo(LOOK_FOR_OBJECT_THREAD, "Turn of %.1f degrees completed in %.2f seconds", theta, yarp::os::Time::now() - t0);
+
         yarp::dev::Nav2D::Map2DLocation loc;
-        m_iNav2D->getCurrentPosition(loc);
-        loc.theta += theta; // <===
-        m_iNav2D->gotoTargetByAbsoluteLocation(loc);
-        yarp::dev::Nav2D::NavigationStatusEnum currentStatus;
-        m_iNav2D->getNavigationStatus(currentStatus);
-        while (currentStatus != yarp::dev::Nav2D::navigation_status_goal_reached  && !m_ext_stop  )
-        {
-            yarp::os::Time::delay(0.2);
-            m_iNav2D->getNavigationStatus(currentStatus);
-        }
+        if (m_iNav2D->getCurrentPosition(loc))
+            m_robotOrient->setPose(loc.map_id, loc.x, loc.y, loc.theta);
 
         if (!m_ext_stop)
             m_status = LfO_SEARCHING;
@@ -336,58 +580,129 @@ bool LookForObjectThread::turn()
 }    
 
 /****************************************************************/
-bool LookForObjectThread::getObjCoordinates(Bottle* btl, Bottle& out)
+bool LookForObjectThread::rotateInPlace(double delta)
 {
-    double max_conf = 0.0;
-    double x = -1.0, y;
-    for (int i=0; i<btl->size(); i++)
+    //the base yaw is driven by velocity commands, closing the loop on the localized heading
+    yarp::dev::Nav2D::Map2DLocation loc;
+    if (!m_iNav2D->getCurrentPosition(loc))
     {
-        Bottle* b = btl->get(i).asList();
-        if (b->get(0).asString() != m_object) //skip objects with another label
-            continue;
-        
-        if(b->get(1).asFloat32() > max_conf) //get the object with the max confidence
+        yCWarning(LOOK_FOR_OBJECT_THREAD, "Cannot retrieve the robot position: turning with the navigation server");
+        return rotateByNavigation(delta);
+    }
+
+    double target = loc.theta + delta;
+    double t0 = yarp::os::Time::now();
+    bool reached {false};
+    while (!m_ext_stop && yarp::os::Time::now() - t0 < m_turn_timeout)
+    {
+        if (!m_iNav2D->getCurrentPosition(loc))
+            break;
+
+        double error = fmod(target - loc.theta, 360.0);
+        if (error > 180.0)  error -= 360.0;
+        if (error < -180.0) error += 360.0;
+        if (fabs(error) <= m_turn_tolerance)
         {
-            max_conf = b->get(1).asFloat32();
-            x = b->get(2).asFloat32();
-            y = b->get(3).asFloat32();
+            reached = true;
+            break;
         }
+
+        double speed = std::min(m_turn_max_speed, std::max(m_turn_min_speed, m_turn_gain * fabs(error)));
+        m_iNav2D->applyVelocityCommand(0.0, 0.0, error > 0 ? speed : -speed, 0.1);  //the base stops by itself if the commands stop
+        if (waitCancelled(0.02))
+            break;
     }
+    m_iNav2D->applyVelocityCommand(0.0, 0.0, 0.0, 0.1);
 
-    if (x<0)
-        return false;
-    
-    out.addFloat32(x);
-    out.addFloat32(y);
-    return true;
+    if (!reached && !m_ext_stop)
+        yCWarning(LOOK_FOR_OBJECT_THREAD, "The robot did not reach the target heading within %.1f seconds", m_turn_timeout);
+    return reached;
 }
 
 /****************************************************************/
-bool LookForObjectThread::writeResult(bool objFound)
+bool LookForObjectThread::rotateByNavigation(double delta)
 {
+    yarp::dev::Nav2D::Map2DLocation loc;
+    m_iNav2D->getCurrentPosition(loc);
+    loc.theta += delta; // <===
+    m_iNav2D->gotoTargetByAbsoluteLocation(loc);
+    yarp::dev::Nav2D::NavigationStatusEnum currentStatus;
+    m_iNav2D->getNavigationStatus(currentStatus);
+    while (currentStatus != yarp::dev::Nav2D::navigation_status_goal_reached  && !waitCancelled(0.05)  )
+    {
+        m_iNav2D->getNavigationStatus(currentStatus);
+    }
+    if (m_ext_stop && currentStatus == yarp::dev::Nav2D::navigation_status_moving)
+        m_iNav2D->stopNavigation();
+
+    return currentStatus == yarp::dev::Nav2D::navigation_status_goal_reached;
+}
+
+/****************************************************************/
+void LookForObjectThread::reportObject(const std::string& label, const Detection& hit)
+{
+    //each object is reported as soon as it is found, and the scan goes on for the others
     yarp::os::Bottle&  toSendOut = m_outPort.prepare();
     toSendOut.clear();
-    if (objFound)
+    toSendOut.addString(label);
+    Bottle& coordList = toSendOut.addList();
+    if (hit.x >= 0 && hit.y >= 0)  //left empty when no detection matches the current head pose
     {
-        toSendOut.addString(m_object);
-        Bottle& coordList = toSendOut.addList();
+        coordList.addFloat32(hit.x);
+        coordList.addFloat32(hit.y);
+    }
+    if (m_gaze_found)
+    {
+        Bottle& gazeList = toSendOut.addList();
+        gazeList.addFloat32(m_gaze_pan);
+        gazeList.addFloat32(m_gaze_tilt);
+    }
+    m_outPort.write();
+
+    m_objects.erase(std::remove(m_objects.begin(), m_objects.end(), label), m_objects.end());
+    m_detections.remove(label);
+    m_gaze_found = false;
+}
 
-        Bottle* finderResult= m_objectCoordsPort.read(false); 
-        if(finderResult != nullptr)
+/****************************************************************/
+bool LookForObjectThread::reportHits(int n, double after)
+{
+    //the gaze angles come from the head pose at the time of the image, the pixel coordinates may be stale if the head was moving
+    std::string label;
+    Detection hit;
+    while (m_detections.hits(n, label, hit, after))
+    {
+        double headPan, headTilt;
+        if (m_robotOrient->headAt(hit.stamp, headPan, headTilt))
         {
-            if (!getObjCoordinates(finderResult, coordList))
-            {
-                toSendOut.clear();
-                toSendOut.addString("object not found");
-                yCWarning(LOOK_FOR_OBJECT_THREAD, "The Object Finder is not seeing any %s", m_object.c_str());
-            }
+            m_robotOrient->pixelToGaze(hit.x, hit.y, headPan, headTilt, m_gaze_pan, m_gaze_tilt);
+            m_gaze_found = true;
+            yCInfo(LOOK_FOR_OBJECT_THREAD, "%s found at pan %.1f tilt %.1f", label.c_str(), m_gaze_pan, m_gaze_tilt);
         }
+        else
+            yCInfo(LOOK_FOR_OBJECT_THREAD, "%s found", label.c_str());
+        reportObject(label, hit);
     }
-    else
+    return m_objects.empty();
+}
+
+/****************************************************************/
+bool LookForObjectThread::writeResult(bool objFound)
+{
+    //the objects found have already been reported: only the missing ones are left
+    if (!objFound)
+    {
+        yarp::os::Bottle&  toSendOut = m_outPort.prepare();
+        toSendOut.clear();
         toSendOut.addString("object not found");
-    m_outPort.write();
+        for (auto& ob : m_objects)
+            toSendOut.addString(ob);
+        m_outPort.write();
+    }
 
-    m_object = "";
+    m_detections.disarm();
+    m_objects.clear();
+    m_gaze_found = false;
     m_status = LfO_IDLE;
     
     return true;
@@ -398,8 +713,13 @@ void LookForObjectThread::externalStop()
 {
     
     yCWarning(LOOK_FOR_OBJECT_THREAD, "External stop command received");
-    m_ext_stop = true;
-    m_status = LfO_IDLE;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requests.clear();
+        m_ext_stop = true;
+    }
+    m_cv.notify_all();
+    m_detections.wakeUp();
 
     yarp::dev::Nav2D::NavigationStatusEnum currentStatus;
     m_iNav2D->getNavigationStatus(currentStatus);
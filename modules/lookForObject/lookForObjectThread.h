@@ -24,7 +24,12 @@
 #include <yarp/dev/INavigation2D.h>
 #include <yarp/os/all.h>
 #include <math.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
 #include "robotOrient.h"
+#include "detectionCallback.h"
 
 
 class LookForObjectThread : public yarp::os::Thread, 
@@ -52,14 +57,35 @@ private:
     yarp::os::RpcClient                         m_findObjectPort;
     std::string                                 m_objectCoordsPortName;
     yarp::os::BufferedPort<yarp::os::Bottle>    m_objectCoordsPort;
+    DetectionCallback                           m_detections;
     std::string                                 m_gazeTargetOutPortName;
     yarp::os::BufferedPort<yarp::os::Bottle>    m_gazeTargetOutPort;
 
     //Others
-    LfO_status                  m_status;
-    std::string                 m_object;
+    std::atomic<LfO_status>     m_status;
+    std::vector<std::string>    m_objects;      //targets not found yet
     double                      m_wait_for_search;
-    bool                        m_ext_stop;
+    double                      m_frame_grace;  //seconds left to the frame of a pose whose deadline has passed
+    std::atomic<bool>           m_ext_stop;     //cancellation token of the running search
+    bool                        m_stop_thread;  //set by onStop, guarded by m_mutex
+    std::mutex                  m_mutex;
+    std::condition_variable     m_cv;
+    std::deque<yarp::os::Bottle> m_requests;
+
+    //in-place rotation
+    bool                        m_closed_loop_turn;
+    double                      m_turn_tolerance;
+    double                      m_turn_gain;
+    double                      m_turn_max_speed;
+    double                      m_turn_min_speed;
+    double                      m_turn_timeout;
+    bool                        m_sweep;
+    int                         m_confirm_frames;
+    double                      m_detector_latency;
+    bool                        m_gaze_found;
+    bool                        m_new_search;
+    double                      m_gaze_pan;
+    double                      m_gaze_tilt;
     yarp::os::ResourceFinder&   m_rf;
     
     RobotOrient*             m_robotOrient;
@@ -80,11 +106,21 @@ public:
     using TypedReaderCallback<yarp::os::Bottle>::onRead;
     void onRead(yarp::os::Bottle& b) override;
 
-    bool lookAround(std::string& ob);
+    bool lookAround();
+    bool sweep();
+    bool startSearch();
+    void rememberView(double pan, double tilt, double after);
+    void sendGazeTarget(double pan, double tilt);
     bool turn();
-    bool getObjCoordinates(Bottle* btl, Bottle& out);
+    bool rotateInPlace(double delta);
+    bool rotateByNavigation(double delta);
     bool writeResult(bool objFound);
+    void reportObject(const std::string& label, const Detection& hit);
+    bool reportHits(int n, double after = 0.0);
     void externalStop();
+    void newSearch(const yarp::os::Bottle& request);
+    bool waitCancelled(double timeout);
+    double frameBudget(double deadline) const;
 
 };
 
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "poseScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+// ********************************************** //
+vector<double> PoseScheduler::axis(double field, double fov, double overlap, double min_pos, double max_pos)
+{
+    vector<double> poses;
+    double reach = (field - fov) / 2.0;     //farthest view centre needed to cover the field
+    if (reach <= 0.0)
+    {
+        poses.push_back(max(min_pos, min(0.0, max_pos)));
+        return poses;
+    }
+
+    double step = fov - overlap;
+    int n = step > 0.0 ? (int)ceil(2.0 * reach / step) + 1 : 2;
+    for (int i=0; i<n; i++)
+    {
+        double p = -reach + 2.0 * reach * i / (n - 1);
+        p = max(min_pos, min(p, max_pos));
+        if (poses.empty() || p - poses.back() > 0.5)   //views squeezed together by the joint limits are merged
+            poses.push_back(p);
+    }
+    return poses;
+}
+
+// ********************************************** //
+double PoseScheduler::travel(const pair<double,double>& a, const pair<double,double>& b)
+{
+    //pan and tilt move together: the slowest joint sets the time of the move
+    return max(fabs(a.first - b.first), fabs(a.second - b.second));
+}
+
+// ********************************************** //
+void PoseScheduler::build(double hFov, double vFov, double overlap, double hField, double vField,
+                          double minPan, double maxPan, double minTilt, double maxTilt)
+{
+    m_pans = axis(hField, hFov, overlap, minPan, maxPan);
+    m_tilts = axis(vField, vFov, overlap, minTilt, maxTilt);
+}
+
+// ********************************************** //
+void PoseScheduler::sequence(double pan, double tilt, vector<pair<double,double>>& poses) const
+{
+    poses.clear();
+    if (m_pans.empty() || m_tilts.empty())
+        return;
+
+    pair<double,double> start {pan, tilt};
+    double best_cost {-1.0};
+    vector<pair<double,double>> candidate;
+
+    //8 serpentines: lines along pan or along tilt, starting from each of the 4 corners
+    for (int by_rows=0; by_rows<2; by_rows++)
+    {
+        const vector<double>& lines = by_rows ? m_tilts : m_pans;
+        const vector<double>& cells = by_rows ? m_pans : m_tilts;
+        for (int lines_up=0; lines_up<2; lines_up++)
+        {
+            for (int cells_up=0; cells_up<2; cells_up++)
+            {
+                candidate.clear();
+                for (size_t l=0; l<lines.size(); l++)
+                {
+                    double line = lines[lines_up ? l : lines.size()-1-l];
+                    bool up = (l % 2 == 0) == (cells_up == 1);
+                    for (size_t c=0; c<cells.size(); c++)
+                    {
+                        double cell = cells[up ? c : cells.size()-1-c];
+                        candidate.push_back(by_rows ? make_pair(cell, line) : make_pair(line, cell));
+                    }
+                }
+
+                double cost = travel(start, candidate.front());
+                for (size_t i=1; i<candidate.size(); i++)
+                    cost += travel(candidate[i-1], candidate[i]);
+
+                if (best_cost < 0.0 || cost < best_cost)
+                {
+                    best_cost = cost;
+                    poses = candidate;
+                }
+            }
+        }
+    }
+}
+
+// ********************************************** //
+double PoseScheduler::panSpan() const
+{
+    return m_pans.empty() ? 0.0 : m_pans.back() - m_pans.front();
+}
+
+// ********************************************** //
+size_t PoseScheduler::size() const
+{
+    return m_pans.size() * m_tilts.size();
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef POSE_SCHEDULER_H
+#define POSE_SCHEDULER_H
+
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+/**
+ * Head poses covering a pan/tilt field with the fewest views.
+ * The poses form a grid: along each axis the field is split in as few views as the camera FOV allows,
+ * keeping at least <overlap> degrees in common between neighbouring views.
+ * The grid is visited in serpentine order (row by row or column by column, reversing direction at each line),
+ * choosing the corner to start from so that the head travels the least from its current position.
+ */
+class PoseScheduler
+{
+private:
+    vector<double>  m_pans;     //ascending
+    vector<double>  m_tilts;    //ascending
+
+    static vector<double> axis(double field, double fov, double overlap, double min_pos, double max_pos);
+    static double travel(const pair<double,double>& a, const pair<double,double>& b);
+
+public:
+    PoseScheduler() = default;
+    ~PoseScheduler() = default;
+
+    void    build(double hFov, double vFov, double overlap, double hField, double vField,
+                  double minPan, double maxPan, double minTilt, double maxTilt);
+    void    sequence(double pan, double tilt, vector<pair<double,double>>& poses) const;
+    double  panSpan() const;
+    size_t  size() const;
+};
+
+#endif
@@ -25,6 +25,16 @@ RobotOrient::RobotOrient(yarp::os::ResourceFinder &rf) : m_rf(rf)
 {
     m_current_turn = 1;
     m_current_orient = 1;
+    m_hfov = 0.0;
+    m_vfov = 0.0;
+    m_img_w = 0;
+    m_img_h = 0;
+    m_settled_at = 0.0;
+    m_plan_valid = false;
+    m_heading = 0.0;
+    m_coverage_width = 0.0;
+    m_x = 0.0;
+    m_y = 0.0;
 }
 
 // ********************************************** //
@@ -35,7 +45,21 @@ bool RobotOrient::configure()
     m_overlap = m_rf.check("fov_overlap_degrees")  ? m_rf.find("fov_overlap_degrees").asFloat32() : 5.0;
     m_turning = m_rf.check("turning")  ? !(m_rf.find("turning").asString() == "false") : true;
 
-    bool useFov = m_rf.check("useCameraFOV") ? m_rf.find("useCameraFOV").asString()=="true" : false;
+    m_settle_velocity = m_rf.check("settle_velocity")  ? m_rf.find("settle_velocity").asFloat32() : 1.0;
+    m_settle_time = m_rf.check("settle_time")  ? m_rf.find("settle_time").asFloat32() : 0.1;
+    m_settle_start = m_rf.check("settle_start_timeout")  ? m_rf.find("settle_start_timeout").asFloat32() : 0.5;
+    m_wait_fresh_frame = m_rf.check("wait_fresh_frame")  ? !(m_rf.find("wait_fresh_frame").asString() == "false") : true;
+
+    m_use_fov = m_rf.check("useCameraFOV") ? m_rf.find("useCameraFOV").asString()=="true" : false;
+    m_plan_scan = m_rf.check("scan_planner")  ? m_rf.find("scan_planner").asString() == "true" : false;
+    m_scan_planner.setParams(m_rf.check("scan_ray_step") ? m_rf.find("scan_ray_step").asFloat32() : 2.0,
+                             m_rf.check("scan_min_free_range") ? m_rf.find("scan_min_free_range").asFloat32() : 1.0,
+                             m_rf.check("scan_max_range") ? m_rf.find("scan_max_range").asFloat32() : 8.0);
+    m_use_memory = m_rf.check("scan_memory")  ? m_rf.find("scan_memory").asString() == "true" : false;
+    m_memory.setParams(m_rf.check("memory_radius") ? m_rf.find("memory_radius").asFloat32() : 0.5,
+                       m_rf.check("memory_ttl") ? m_rf.find("memory_ttl").asFloat32() : 120.0);
+    double hField = m_rf.check("scan_field_horizontal")  ? m_rf.find("scan_field_horizontal").asFloat32() : 180.0;
+    double vField = m_rf.check("scan_field_vertical")  ? m_rf.find("scan_field_vertical").asFloat32() : 90.0;
 
     // --------- RGBDSensor config --------- //
     Property rgbdProp;
@@ -137,21 +161,27 @@ bool RobotOrient::configure()
         return false;
     }
 
+    m_Poly.view(m_iencs);
+    if(!m_iencs)
+    {
+        yCWarning(ROBOT_ORIENT,"Error opening IEncodersTimed interface. Head settling will fall back to a fixed delay");
+    }
+
     // ----------- Configure Head Positions ----------- //
-    map<string, pair<double,double>>  orientations_default{
-        {"pos01" , {0.0, 0.0}    },
-        {"pos02" , {35.0, 0.0}   },
-        {"pos03" , {-35.0, 0.0}  },
-        {"pos04" , {0.0, 20.0}   },
-        {"pos05" , {35.0, 20.0}  },
-        {"pos06" , {-35.0, 20.0} },
-        {"pos07" , {0.0, -20.0}  },
-        {"pos08" , {35.0, -20.0} },
-        {"pos09" , {-35.0, -20.0}}   };
+    vector<pair<double,double>>  orientations_default{
+        {0.0, 0.0}    ,
+        {35.0, 0.0}   ,
+        {-35.0, 0.0}  ,
+        {0.0, 20.0}   ,
+        {35.0, 20.0}  ,
+        {-35.0, 20.0} ,
+        {0.0, -20.0}  ,
+        {35.0, -20.0} ,
+        {-35.0, -20.0}   };
 
     double visual_span;
     
-    if (!useFov) 
+    if (!m_use_fov) 
     {
         if(!m_rf.check("HEAD_POSITIONS"))
         {
@@ -176,7 +206,7 @@ bool RobotOrient::configure()
                 ss >> s; double n1 = stod(s);
                 ss >> s; double n2 = stod(s);            
 
-                m_orientations.insert({pos, {n1,n2} });
+                m_orientations.push_back({n1,n2});
                 idx++;
 
                 maxDeg = n1>maxDeg ? n1 : maxDeg;
@@ -188,55 +218,56 @@ bool RobotOrient::configure()
     else 
     {
         double verticalFov{0.0}, horizontalFov{0.0};
-        double newVFov{0.0}, newHFov{0.0};
         bool fovGot = m_iRgbd->getRgbFOV(horizontalFov,verticalFov);
         if(!fovGot)
         {
-            yCError(ROBOT_ORIENT,"An error occurred while retrieving the rgb camera FOV");
+            yCError(ROBOT_ORIENT,"An error occurred while retrieving the rgb camera FOV. Using default head positions");
+            m_orientations = orientations_default;
+            visual_span = 70.0;
         }
         else
         {
-            //consider the width of the fov to inspect an area of 180 degrees laterally and 90 degrees vertically
-            // overlapping the views by at least <m_overlap> degrees
-            newHFov = horizontalFov>60 ?  (90.0 - horizontalFov/2) : (horizontalFov-m_overlap) ;
-            newVFov = verticalFov>30 ?  (45.0 - verticalFov/2) : (verticalFov-m_overlap) ;
-        }
-        
-        double min_pos_h {0}, min_pos_v {0};
-        double max_pos_h {100}, max_pos_v {100};
+            double min_pos_h {-90.0}, min_pos_v {-45.0};
+            double max_pos_h {90.0}, max_pos_v {45.0};
 
-        bool limGotV = m_ilimctrl->getLimits(0, &min_pos_v, &max_pos_v); //pitch
-        bool limGotH = m_ilimctrl->getLimits(1, &min_pos_h, &max_pos_h); //yaw
-        if(!limGotV || !limGotH)
-        {
-            yCError(ROBOT_ORIENT,"An error occurred while retrieving the head joint limits");
-        }
+            bool limGotV = m_ilimctrl->getLimits(0, &min_pos_v, &max_pos_v); //pitch
+            bool limGotH = m_ilimctrl->getLimits(1, &min_pos_h, &max_pos_h); //yaw
+            if(!limGotV || !limGotH)
+            {
+                yCError(ROBOT_ORIENT,"An error occurred while retrieving the head joint limits");
+            }
 
-        double up = limGotV ? min(fovGot ? newVFov : 20.0 , max_pos_v) : (fovGot ? newVFov : 20.0);
-        double down = limGotV ? max(fovGot ? -newVFov : -20.0 , min_pos_v) : (fovGot ? -newVFov : -20.0);
-        double left = limGotH ? min(fovGot ? newHFov : 35.0 , max_pos_h) : (fovGot ? newHFov : 35.0);;
-        double right = limGotH ? max(fovGot ? -newHFov : -35.0 , min_pos_h) : (fovGot ? -newHFov : -35.0); 
-
-        m_orientations = {
-            {"pos01", {0.0,  0.0}  },
-            {"pos02", {left, 0.0}  },   //left
-            {"pos03", {right,0.0}  },   //right
-            {"pos04", {0.0,  up}   },   //up
-            {"pos05", {left, up}   },   //up left
-            {"pos06", {right,up}   },   //up right
-            {"pos07", {0.0,  down} },   //down
-            {"pos08", {left, down} },   //down left
-            {"pos09", {right,down} }};  //down right
-
-        visual_span = left-right;
+            //cover <hField> degrees laterally and <vField> degrees vertically with the fewest views,
+            // overlapping them by at least <m_overlap> degrees
+            m_scheduler.build(horizontalFov, verticalFov, m_overlap, hField, vField, min_pos_h, max_pos_h, min_pos_v, max_pos_v);
+            m_scheduler.sequence(0.0, 0.0, m_orientations);
+            visual_span = m_scheduler.panSpan();
+            yCInfo(ROBOT_ORIENT,"%zu head orientations scheduled to cover %.1f x %.1f degrees", m_scheduler.size(), hField, vField);
+        }
     }
 
-    double _v_, horizontalFov{0.0};
-    if(!m_iRgbd->getRgbFOV(horizontalFov,_v_))
+    double verticalFov{0.0}, horizontalFov{0.0};
+    if(!m_iRgbd->getRgbFOV(horizontalFov,verticalFov))
         yCError(ROBOT_ORIENT,"An error occurred while retrieving the rgb camera FOV");
+    m_hfov = horizontalFov;
+    m_vfov = verticalFov;
+    m_img_w = m_iRgbd->getRgbWidth();
+    m_img_h = m_iRgbd->getRgbHeight();
+    if (horizontalFov > 0.0 && verticalFov > 0.0)
+        m_memory.setTolerance(horizontalFov/4, verticalFov/4);
+
+    // ----------- Sweep speed ----------- //
+    //each point of the scene must stay in the FOV for <frames_per_fov> detector frames
+    double detector_fps = m_rf.check("detector_fps")  ? m_rf.find("detector_fps").asFloat32() : 5.0;
+    double frames_per_fov = m_rf.check("sweep_frames_per_fov")  ? m_rf.find("sweep_frames_per_fov").asFloat32() : 3.0;
+    double max_speed = m_rf.check("sweep_max_speed")  ? m_rf.find("sweep_max_speed").asFloat32() : 30.0;
+    double sweep_fov = horizontalFov > m_overlap ? horizontalFov - m_overlap : 35.0;
+    m_sweep_speed = min(max_speed, sweep_fov * detector_fps / max(frames_per_fov, 1.0));
     
-    m_max_turns = ceil(360.0/(visual_span+horizontalFov));
+    m_coverage_width = visual_span+horizontalFov;
+    m_max_turns = ceil(360.0/m_coverage_width);
     m_turn_deg = 360.0/m_max_turns;
+    m_configured = m_orientations;
 
     return true;
 }
@@ -245,11 +276,10 @@ bool RobotOrient::configure()
 bool RobotOrient::next(Bottle& reply)
 {
     lock_guard<mutex> m_lock(m_mutex);
-    string posname = "pos" + (string)(m_current_orient<10?"0":"") + to_string(m_current_orient);
-    if (m_orientations.find(posname) != m_orientations.end())
+    if (m_current_orient <= (int)m_orientations.size())
     {
         Bottle& tempList = reply.addList();
-        pair<double,double> tempPair = m_orientations.at(posname);
+        pair<double,double> tempPair = m_orientations[m_current_orient-1];
         tempList.addFloat32(tempPair.first);
         tempList.addFloat32(tempPair.second);
         m_current_orient++;
@@ -275,28 +305,151 @@ void RobotOrient::help()
 bool RobotOrient::turn(Bottle& reply)
 { 
     lock_guard<mutex> m_lock(m_mutex);
-    if (m_turning && m_current_turn<m_max_turns)
+
+    //headings with nothing left to see (only walls or views remembered from a recent scan) are skipped
+    double target {m_heading};
+    while (m_turning && nextHeading(target))
     {
-        reply.addFloat32(m_turn_deg);
-        m_current_turn++;
+        if (worthScanning(target))
+        {
+            reply.addFloat32(ScanPlanner::wrap(target - m_heading + 180.0) - 180.0);
+            m_heading = target;
+            return true;
+        }
     }
-    else
-        reply.addString("noTurn");
-    
+    reply.addString("noTurn");
     
     return true;
 }
 
+// ********************************************** //
+bool RobotOrient::nextHeading(double& heading)
+{
+    if (m_plan_valid)
+    {
+        if (m_current_turn > (int)m_plan_headings.size())
+            return false;
+        heading = m_plan_headings[m_current_turn-1];
+    }
+    else
+    {
+        if (m_current_turn >= m_max_turns)
+            return false;
+        heading += m_turn_deg;
+    }
+    m_current_turn++;
+    return true;
+}
+
+// ********************************************** //
+bool RobotOrient::worthScanning(double heading)
+{
+    double now = Time::now();
+    for (auto& o : m_configured)
+    {
+        if (m_plan_valid && !m_scan_planner.isOpen(heading + o.first - m_hfov/2, heading + o.first + m_hfov/2))
+            continue;
+        if (m_use_memory && m_memory.isSeen(m_map, m_x, m_y, heading + o.first, o.second, now))
+            continue;
+        return true;
+    }
+    return false;
+}
+
 // ********************************************** //
 void RobotOrient::resetOrients()
 { 
+    lock_guard<mutex> m_lock(m_mutex);
     m_current_orient = 1;
+
+    //restart the serpentine from the corner closest to where the head is now
+    double pan {0.0}, tilt {0.0};
+    if (m_use_fov && m_scheduler.size() > 0 && getHeadPosition(pan, tilt))
+        m_scheduler.sequence(pan, tilt, m_configured);
+
+    //skip the orientations whose view only faces nearby walls or has been seen recently from here
+    double now = Time::now();
+    m_orientations.clear();
+    for (auto& o : m_configured)
+    {
+        if (m_plan_valid && !m_scan_planner.isOpen(m_heading + o.first - m_hfov/2, m_heading + o.first + m_hfov/2))
+            continue;
+        if (m_use_memory && m_memory.isSeen(m_map, m_x, m_y, m_heading + o.first, o.second, now))
+            continue;
+        m_orientations.push_back(o);
+    }
+    if (m_orientations.size() < m_configured.size())
+        yCInfo(ROBOT_ORIENT,"%zu of %zu head orientations face a wall or were seen recently and are skipped", m_configured.size() - m_orientations.size(), m_configured.size());
+}
+
+// ********************************************** //
+void RobotOrient::setPose(const string& map, double x, double y, double theta)
+{
+    lock_guard<mutex> m_lock(m_mutex);
+    m_map = map;
+    m_x = x;
+    m_y = y;
+    m_heading = theta;
+    m_memory.prune(Time::now());
+}
+
+// ********************************************** //
+void RobotOrient::remember(double pan, double tilt, const Bottle& detections)
+{
+    lock_guard<mutex> m_lock(m_mutex);
+    if (m_use_memory)
+        m_memory.remember(m_map, m_x, m_y, m_heading + pan, tilt, detections, Time::now());
+}
+
+// ********************************************** //
+bool RobotOrient::recall(const string& label, double& pan, double& tilt)
+{
+    lock_guard<mutex> m_lock(m_mutex);
+    double absPan;
+    if (!m_use_memory || !m_memory.recall(m_map, m_x, m_y, label, Time::now(), absPan, tilt))
+        return false;
+
+    pan = ScanPlanner::wrap(absPan - m_heading + 180.0) - 180.0;    //relative to the base
+    return true;
+}
+
+// ********************************************** //
+bool RobotOrient::planScan(const MapGrid2D& map, double x, double y, double theta)
+{
+    lock_guard<mutex> m_lock(m_mutex);
+    m_current_turn = 1;
+    m_plan_valid = m_plan_scan && m_scan_planner.plan(map, x, y, theta, m_coverage_width, m_plan_headings);
+    if (m_plan_valid)
+        yCInfo(ROBOT_ORIENT,"Scan planned with %zu turns (instead of %d)", m_plan_headings.size(), m_max_turns-1);
+    return m_plan_valid;
+}
+
+// ********************************************** //
+bool RobotOrient::getHeadPosition(double& pan, double& tilt)
+{
+    if (!m_iencs)
+        return false;
+
+    int axes {0};
+    m_iencs->getAxes(&axes);
+    if (axes < 2)
+        return false;
+
+    vector<double> encs(axes, 0.0);
+    if (!m_iencs->getEncoders(encs.data()))
+        return false;
+
+    tilt = encs[0];     //pitch
+    pan = encs[1];      //yaw
+    return true;
 }
 
 // ********************************************** //
 void RobotOrient::resetTurns()
 { 
+    lock_guard<mutex> m_lock(m_mutex);
     m_current_turn = 1;
+    m_plan_valid = false;
 }
 
 // ********************************************** //
@@ -322,6 +475,192 @@ void RobotOrient::home()
     
 }
 
+// ********************************************** //
+RobotOrient::SettleResult RobotOrient::waitSettled(double timeout, function<bool()> stop)
+{
+    double t0 = Time::now();
+    m_settled_at = t0;
+    if (!m_iencs)
+    {
+        //without encoders the head is assumed still once the whole timeout has elapsed
+        while (Time::now() - t0 < timeout)
+        {
+            if (stop && stop())
+                return SETTLE_STOPPED;
+            Time::delay(0.02);
+        }
+        m_settled_at = Time::now();
+        return SETTLE_DONE;
+    }
+
+    int axes {0};
+    m_iencs->getAxes(&axes);
+    vector<double> speeds(axes, 0.0);
+
+    // the gaze controller may take a while before the head starts moving:
+    // a still head counts as settled only once it moved or after <m_settle_start> seconds
+    bool moved {false};
+    double still_since {-1.0};
+    while (Time::now() - t0 < timeout)
+    {
+        if (stop && stop())
+            return SETTLE_STOPPED;
+
+        double now = Time::now();
+        double max_speed {0.0};
+        if (axes > 0 && m_iencs->getEncoderSpeeds(speeds.data()))
+        {
+            for (double s : speeds)
+                max_speed = max(max_speed, fabs(s));
+        }
+
+        if (max_speed > m_settle_velocity)
+        {
+            moved = true;
+            still_since = -1.0;
+        }
+        else
+        {
+            if (still_since < 0)
+                still_since = now;
+            if ((moved || now - t0 > m_settle_start) && now - still_since >= m_settle_time)
+                break;
+        }
+        Time::delay(0.02);
+    }
+
+    double settled = Time::now();
+    m_settled_at = settled;
+    if (settled - t0 >= timeout)
+    {
+        yCWarning(ROBOT_ORIENT,"The head did not settle within %.2f seconds", timeout);
+        return SETTLE_TIMEOUT;
+    }
+
+    yCDebug(ROBOT_ORIENT,"Head settled in %.2f seconds", settled - t0);
+    bool stopped {false};
+    auto stopFrame = [&stop, &stopped]() { stopped = stop && stop(); return stopped; };
+    if (m_wait_fresh_frame && !waitFreshFrame(settled, timeout - (settled - t0), stopFrame) && stopped)
+        return SETTLE_STOPPED;
+    return SETTLE_DONE;
+}
+
+// ********************************************** //
+bool RobotOrient::waitFreshFrame(double after, double timeout, function<bool()> stop)
+{
+    double t0 = Time::now();
+    Stamp stamp;
+    while (Time::now() - t0 < timeout)
+    {
+        if (stop && stop())
+            return false;
+
+        if (m_iRgbd->getRgbImage(m_frame, &stamp) && stamp.isValid() && stamp.getTime() > after)
+            return true;
+        Time::delay(0.01);
+    }
+
+    yCWarning(ROBOT_ORIENT,"No camera frame acquired after the head settled");
+    return false;
+}
+
+// ********************************************** //
+void RobotOrient::sweepRows(vector<SweepRow>& rows)
+{
+    lock_guard<mutex> m_lock(m_mutex);
+    rows.clear();
+
+    //one row for each tilt of the head orientations, spanning all their pans
+    vector<double> tilts;
+    if (m_orientations.empty())
+        return;
+    double left {m_orientations[0].first}, right {m_orientations[0].first};
+    for (auto& o : m_orientations)
+    {
+        if (find(tilts.begin(), tilts.end(), o.second) == tilts.end())
+            tilts.push_back(o.second);
+        left = max(left, o.first);
+        right = min(right, o.first);
+    }
+    sort(tilts.begin(), tilts.end());
+
+    //serpentine starting from the closest corner
+    double pan {0.0}, tilt {0.0};
+    getHeadPosition(pan, tilt);
+    if (fabs(tilt - tilts.back()) < fabs(tilt - tilts.front()))
+        reverse(tilts.begin(), tilts.end());
+    bool to_right = fabs(pan - left) < fabs(pan - right);
+    for (double t : tilts)
+    {
+        rows.push_back(to_right ? SweepRow{t, left, right} : SweepRow{t, right, left});
+        to_right = !to_right;
+    }
+}
+
+// ********************************************** //
+void RobotOrient::recordHead()
+{
+    if (!m_iencs)
+        return;
+
+    int axes {0};
+    m_iencs->getAxes(&axes);
+    if (axes < 2)
+        return;
+
+    vector<double> encs(axes, 0.0), times(axes, 0.0);
+    if (!m_iencs->getEncodersTimed(encs.data(), times.data()))
+        return;
+
+    lock_guard<mutex> m_lock(m_mutex);
+    m_head_history.emplace_back(times[1], encs[1], encs[0]);
+    while (m_head_history.size() > 1 && get<0>(m_head_history.back()) - get<0>(m_head_history.front()) > 5.0)
+        m_head_history.pop_front();
+}
+
+// ********************************************** //
+bool RobotOrient::headAt(double t, double& pan, double& tilt)
+{
+    lock_guard<mutex> m_lock(m_mutex);
+    if (m_head_history.empty())
+        return false;
+
+    //linear interpolation between the two samples around <t>, clamped to the recorded interval
+    auto after = m_head_history.begin();
+    while (after != m_head_history.end() && get<0>(*after) < t)
+        after++;
+
+    if (after == m_head_history.begin() || after == m_head_history.end())
+    {
+        auto& s = after == m_head_history.end() ? m_head_history.back() : m_head_history.front();
+        pan = get<1>(s);
+        tilt = get<2>(s);
+        return true;
+    }
+
+    auto before = after - 1;
+    double dt = get<0>(*after) - get<0>(*before);
+    double k = dt > 0.0 ? (t - get<0>(*before)) / dt : 0.0;
+    pan = get<1>(*before) + k * (get<1>(*after) - get<1>(*before));
+    tilt = get<2>(*before) + k * (get<2>(*after) - get<2>(*before));
+    return true;
+}
+
+// ********************************************** //
+void RobotOrient::pixelToGaze(double x, double y, double headPan, double headTilt, double& pan, double& tilt) const
+{
+    pan = headPan;
+    tilt = headTilt;
+    if (m_img_w <= 0 || m_img_h <= 0 || m_hfov <= 0.0 || m_vfov <= 0.0)
+        return;
+
+    //pinhole model: pan grows to the left and tilt upwards, image coordinates the other way round
+    double fx = (m_img_w / 2.0) / tan(m_hfov * M_PI / 360.0);
+    double fy = (m_img_h / 2.0) / tan(m_vfov * M_PI / 360.0);
+    pan -= atan((x - m_img_w / 2.0) / fx) * 180.0 / M_PI;
+    tilt -= atan((y - m_img_h / 2.0) / fy) * 180.0 / M_PI;
+}
+
 // ********************************************** //
 bool RobotOrient::close()
 {
@@ -26,11 +26,19 @@
 #include <yarp/os/Time.h>
 #include <yarp/os/Port.h>
 #include <yarp/os/RFModule.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/sig/Image.h>
 #include <yarp/dev/ControlBoardInterfaces.h>
 #include <map>
+#include <deque>
+#include <tuple>
+#include <functional>
 #include <vector>
 #include <algorithm>
 #include <math.h>
+#include "poseScheduler.h"
+#include "scanPlanner.h"
+#include "scanMemory.h"
 
 //Defaults RGBD sensor
 #define RGBDClient            "RGBDSensorClient"
@@ -56,12 +64,31 @@ private:
     IControlMode*         m_ictrlmode;     
     IPositionControl*     m_iposctrl;
     IControlLimits*       m_ilimctrl;      
+    IEncodersTimed*       m_iencs{nullptr};
 
     PolyDriver            m_rgbdPoly;
     IRGBDSensor*          m_iRgbd{nullptr};
 
     //head orientations
-    map<string, pair<double,double>>         m_orientations;
+    vector<pair<double,double>>              m_orientations;
+    PoseScheduler                            m_scheduler;
+    bool                                     m_use_fov;
+    vector<pair<double,double>>              m_configured;      //orientations before dropping the ones facing walls
+
+    //scan planning
+    bool                  m_plan_scan;
+    ScanPlanner           m_scan_planner;
+    bool                  m_plan_valid;
+    vector<double>        m_plan_headings;
+    double                m_heading;
+    double                m_coverage_width;
+
+    //scan memory
+    bool                  m_use_memory;
+    ScanMemory            m_memory;
+    string                m_map;
+    double                m_x;
+    double                m_y;
 
     //turn around
     bool                  m_turning;
@@ -70,6 +97,25 @@ private:
     int                   m_current_turn;
     int                   m_current_orient;
 
+    bool nextHeading(double& heading);
+    bool worthScanning(double heading);
+
+    //head settling
+    double                m_settle_velocity;
+    double                m_settle_time;
+    double                m_settle_start;
+    bool                  m_wait_fresh_frame;
+    double                m_settled_at;
+    yarp::sig::FlexImage  m_frame;
+
+    //sweep
+    double                m_hfov;
+    double                m_vfov;
+    int                   m_img_w;
+    int                   m_img_h;
+    double                m_sweep_speed;
+    deque<tuple<double,double,double>>  m_head_history;   //(time, pan, tilt)
+
     //others
     double                m_period;
     double                m_overlap;
@@ -87,9 +133,31 @@ public:
 
     bool next(Bottle& reply);
     bool turn(Bottle& reply);
+    bool planScan(const MapGrid2D& map, double x, double y, double theta);
+    bool scanPlanning() const { return m_plan_scan; }
+    void setPose(const string& map, double x, double y, double theta);
+    void remember(double pan, double tilt, const Bottle& detections);
+    bool recall(const string& label, double& pan, double& tilt);
     void resetOrients();
+    bool getHeadPosition(double& pan, double& tilt);
     void resetTurns();
     void home();
+    enum SettleResult
+    {
+        SETTLE_DONE,        //the head is still (and a fresh frame was acquired, if required)
+        SETTLE_STOPPED,     //the stop predicate fired first
+        SETTLE_TIMEOUT      //the head did not settle in time
+    };
+    SettleResult waitSettled(double timeout, function<bool()> stop = nullptr);
+    double settledAt() const { return m_settled_at; }
+    bool waitFreshFrame(double after, double timeout, function<bool()> stop = nullptr);
+
+    struct SweepRow { double tilt; double from; double to; };
+    void   sweepRows(vector<SweepRow>& rows);
+    double sweepSpeed() const { return m_sweep_speed; }
+    void   recordHead();
+    bool   headAt(double t, double& pan, double& tilt);
+    void   pixelToGaze(double x, double y, double headPan, double headTilt, double& pan, double& tilt) const;
     void help();
 };
 
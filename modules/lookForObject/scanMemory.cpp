@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "scanMemory.h"
+#include <algorithm>
+#include <cmath>
+
+
+// ********************************************** //
+static double angleDiff(double a, double b)
+{
+    double d = fmod(a - b, 360.0);
+    if (d > 180.0)  d -= 360.0;
+    if (d < -180.0) d += 360.0;
+    return fabs(d);
+}
+
+// ********************************************** //
+ScanMemory::ScanMemory() :
+    m_radius(0.5),
+    m_ttl(120.0),
+    m_pan_tol(10.0),
+    m_tilt_tol(10.0)
+{
+}
+
+// ********************************************** //
+void ScanMemory::setParams(double radius, double ttl)
+{
+    m_radius = radius;
+    m_ttl = ttl;
+}
+
+// ********************************************** //
+void ScanMemory::setTolerance(double pan, double tilt)
+{
+    m_pan_tol = pan;
+    m_tilt_tol = tilt;
+}
+
+// ********************************************** //
+ScanSpot* ScanMemory::find(const string& map, double x, double y)
+{
+    for (auto& s : m_spots)
+    {
+        if (s.map == map && hypot(s.x - x, s.y - y) <= m_radius)
+            return &s;
+    }
+    return nullptr;
+}
+
+// ********************************************** //
+const ScanSpot* ScanMemory::find(const string& map, double x, double y) const
+{
+    return const_cast<ScanMemory*>(this)->find(map, x, y);
+}
+
+// ********************************************** //
+bool ScanMemory::fresh(const ScanView& v, double now) const
+{
+    return now - v.time <= m_ttl;
+}
+
+// ********************************************** //
+void ScanMemory::remember(const string& map, double x, double y, double pan, double tilt, const Bottle& detections, double now)
+{
+    ScanSpot* spot = find(map, x, y);
+    if (!spot)
+    {
+        m_spots.push_back(ScanSpot{map, x, y, {}});
+        spot = &m_spots.back();
+    }
+
+    ScanView view {pan, tilt, now, detections};
+    for (auto& v : spot->views)
+    {
+        if (angleDiff(v.pan, pan) <= m_pan_tol && fabs(v.tilt - tilt) <= m_tilt_tol)
+        {
+            v = view;
+            return;
+        }
+    }
+    spot->views.push_back(view);
+}
+
+// ********************************************** //
+bool ScanMemory::isSeen(const string& map, double x, double y, double pan, double tilt, double now) const
+{
+    const ScanSpot* spot = find(map, x, y);
+    if (!spot)
+        return false;
+
+    for (auto& v : spot->views)
+    {
+        if (fresh(v, now) && angleDiff(v.pan, pan) <= m_pan_tol && fabs(v.tilt - tilt) <= m_tilt_tol)
+            return true;
+    }
+    return false;
+}
+
+// ********************************************** //
+bool ScanMemory::recall(const string& map, double x, double y, const string& label, double now, double& pan, double& tilt) const
+{
+    const ScanSpot* spot = find(map, x, y);
+    if (!spot)
+        return false;
+
+    //the most recent view with <label> in it
+    double newest {-1.0};
+    for (auto& v : spot->views)
+    {
+        if (!fresh(v, now) || v.time <= newest)
+            continue;
+        for (size_t i=0; i<v.detections.size(); i++)
+        {
+            Bottle* obj = v.detections.get(i).asList();
+            if (obj && obj->get(0).asString() == label)
+            {
+                newest = v.time;
+                pan = v.pan;
+                tilt = v.tilt;
+                break;
+            }
+        }
+    }
+    return newest >= 0.0;
+}
+
+// ********************************************** //
+void ScanMemory::prune(double now)
+{
+    for (auto& s : m_spots)
+    {
+        s.views.erase(remove_if(s.views.begin(), s.views.end(), [&](const ScanView& v) { return !fresh(v, now); }), s.views.end());
+    }
+    m_spots.erase(remove_if(m_spots.begin(), m_spots.end(), [](const ScanSpot& s) { return s.views.empty(); }), m_spots.end());
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SCAN_MEMORY_H
+#define SCAN_MEMORY_H
+
+#include <yarp/os/Bottle.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace yarp::os;
+
+struct ScanView
+{
+    double  pan;            //absolute [deg]: base heading plus head pan
+    double  tilt;
+    double  time;
+    Bottle  detections;     //everything the object finder saw in this view
+};
+
+struct ScanSpot
+{
+    string              map;
+    double              x;
+    double              y;
+    vector<ScanView>    views;
+};
+
+/**
+ * What the robot has seen from the spots where it searched.
+ * A spot collects the views taken within <radius> meters from it: a view replaces the previous ones looking (almost) the same way,
+ * and is forgotten after <ttl> seconds.
+ */
+class ScanMemory
+{
+private:
+    vector<ScanSpot>    m_spots;
+    double              m_radius;
+    double              m_ttl;
+    double              m_pan_tol;
+    double              m_tilt_tol;
+
+    ScanSpot*       find(const string& map, double x, double y);
+    const ScanSpot* find(const string& map, double x, double y) const;
+    bool            fresh(const ScanView& v, double now) const;
+
+public:
+    ScanMemory();
+    ~ScanMemory() = default;
+
+    void    setParams(double radius, double ttl);
+    void    setTolerance(double pan, double tilt);
+    void    remember(const string& map, double x, double y, double pan, double tilt, const Bottle& detections, double now);
+    bool    isSeen(const string& map, double x, double y, double pan, double tilt, double now) const;
+    bool    recall(const string& map, double x, double y, const string& label, double now, double& pan, double& tilt) const;
+    void    prune(double now);
+};
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "scanPlanner.h"
+#include <algorithm>
+#include <cmath>
+
+
+// ********************************************** //
+ScanPlanner::ScanPlanner() :
+    m_ray_step(2.0),
+    m_min_range(1.0),
+    m_max_range(8.0)
+{
+}
+
+// ********************************************** //
+void ScanPlanner::setParams(double rayStep, double minRange, double maxRange)
+{
+    m_ray_step = rayStep > 0.0 ? rayStep : 2.0;
+    m_min_range = minRange;
+    m_max_range = maxRange;
+}
+
+// ********************************************** //
+double ScanPlanner::wrap(double deg)
+{
+    deg = fmod(deg, 360.0);
+    return deg < 0.0 ? deg + 360.0 : deg;
+}
+
+// ********************************************** //
+double ScanPlanner::castRay(const MapGrid2D& map, double x, double y, double heading) const
+{
+    //only walls stop the ray: furniture and inflated obstacles may hold the object we are looking for
+    double res {0.05};
+    map.getResolution(res);
+    double step = res / 2.0;
+    double c = cos(heading * M_PI / 180.0);
+    double s = sin(heading * M_PI / 180.0);
+    for (double d = 0.0; d < m_max_range; d += step)
+    {
+        XYWorld p(x + d * c, y + d * s);
+        if (!map.isInsideMap(p))
+            return d;
+        if (map.isWall(map.world2Cell(p)))
+            return d;
+    }
+    return m_max_range;
+}
+
+// ********************************************** //
+bool ScanPlanner::plan(const MapGrid2D& map, double x, double y, double theta, double width, vector<double>& headings)
+{
+    headings.clear();
+    m_open.clear();
+    if (width <= 0.0)
+        return false;
+
+    for (double h = 0.0; h < 360.0; h += m_ray_step)
+    {
+        if (castRay(map, x, y, h) >= m_min_range)
+            m_open.push_back(h);
+    }
+
+    //the rays seen from the current heading do not need a turn
+    theta = wrap(theta);
+    vector<double> todo;
+    for (double h : m_open)
+    {
+        double off = wrap(h - theta);
+        if (off > width / 2.0 && off < 360.0 - width / 2.0)
+            todo.push_back(off);     //offset from the current heading, in (width/2, 360-width/2)
+    }
+    if (todo.empty())
+        return true;
+
+    //greedy covering of the points on the arc: starting from each point, arcs of <width> degrees are chained counterclockwise
+    // until all the points are covered; the start leading to the fewest arcs wins
+    sort(todo.begin(), todo.end());
+    vector<double> best;
+    for (size_t start = 0; start < todo.size(); start++)
+    {
+        vector<double> centres;
+        double arc_end {-1.0};
+        for (size_t i = 0; i < todo.size(); i++)
+        {
+            double off = todo[(start + i) % todo.size()];
+            double rel = wrap(off - todo[start]);     //position along the chain
+            if (centres.empty() || rel > arc_end)
+            {
+                centres.push_back(wrap(off + width / 2.0));
+                arc_end = rel + width;
+            }
+        }
+        if (best.empty() || centres.size() < best.size())
+            best = centres;
+    }
+
+    //visit the headings rotating in a single direction, the one with the shortest total rotation
+    sort(best.begin(), best.end());
+    bool ccw = best.back() <= 360.0 - best.front();
+    if (!ccw)
+        reverse(best.begin(), best.end());
+    for (double off : best)
+        headings.push_back(wrap(theta + off));
+
+    return true;
+}
+
+// ********************************************** //
+bool ScanPlanner::isOpen(double from, double to) const
+{
+    //<from> and <to> are absolute headings, the arc goes counterclockwise from <from> to <to>
+    double span = wrap(to - from);
+    for (double h : m_open)
+    {
+        if (wrap(h - from) <= span)
+            return true;
+    }
+    return false;
+}
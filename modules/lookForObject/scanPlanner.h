@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SCAN_PLANNER_H
+#define SCAN_PLANNER_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <vector>
+
+using namespace std;
+using namespace yarp::dev::Nav2D;
+
+/**
+ * Plans the base headings from which the robot scans its surroundings.
+ * Rays are cast on the global map all around the robot: the directions hitting a wall closer than <min_range> face a wall
+ * and are not worth looking at. The remaining (open) directions are covered with the fewest headings,
+ * each covering <width> degrees (head pan span plus camera FOV), the one the robot is facing being always the first.
+ * The headings are ordered to rotate the base the least.
+ */
+class ScanPlanner
+{
+private:
+    double          m_ray_step;
+    double          m_min_range;
+    double          m_max_range;
+    vector<double>  m_open;         //headings [deg, 0-360) of the rays not facing a near wall
+
+    double  castRay(const MapGrid2D& map, double x, double y, double heading) const;
+
+public:
+    ScanPlanner();
+    ~ScanPlanner() = default;
+
+    void    setParams(double rayStep, double minRange, double maxRange);
+    bool    plan(const MapGrid2D& map, double x, double y, double theta, double width, vector<double>& headings);
+    bool    isOpen(double from, double to) const;
+
+    static double wrap(double deg);
+};
+
+#endif
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "areaIndex.h"
+
+/****************************************************************/
+AreaIndex::AreaIndex() :
+    m_separator("_"),
+    m_use_prefixes(true)
+{
+    clear();
+}
+
+/****************************************************************/
+void AreaIndex::setSeparator(const string& separator)
+{
+    m_separator = separator;
+}
+
+/****************************************************************/
+void AreaIndex::useNamePrefixes(bool use)
+{
+    m_use_prefixes = use;
+}
+
+/****************************************************************/
+void AreaIndex::assign(const string& location_name, const string& path)
+{
+    m_assigned[location_name] = path;
+}
+
+/****************************************************************/
+void AreaIndex::clear()
+{
+    //the assignments from the configuration are kept
+    m_nodes.clear();
+    m_by_path.clear();
+    m_by_name.clear();
+    m_area_of.clear();
+
+    AreaNode root;
+    root.parent = -1;
+    m_nodes.push_back(root);
+    m_by_path[""] = 0;
+}
+
+/****************************************************************/
+int AreaIndex::node(const string& path)
+{
+    auto it = m_by_path.find(path);
+    if (it != m_by_path.end())
+        return it->second;
+
+    //the parent areas are created first, walking the path up to the root
+    size_t cut = path.rfind('/');
+    int parent = cut == string::npos ? 0 : node(path.substr(0, cut));
+
+    AreaNode area;
+    area.name = cut == string::npos ? path : path.substr(cut + 1);
+    area.path = path;
+    area.parent = parent;
+    int id = (int)m_nodes.size();
+    m_nodes.push_back(area);
+    m_nodes[parent].children.push_back(id);
+    m_by_path[path] = id;
+    m_by_name.insert(make_pair(m_nodes[id].name, id));
+    return id;
+}
+
+/****************************************************************/
+void AreaIndex::addLocation(size_t id, const string& name)
+{
+    if (id < m_area_of.size() && m_area_of[id] >= 0)
+        return;     //already indexed
+
+    string path;
+    auto it = m_assigned.find(name);
+    if (it != m_assigned.end())
+        path = it->second;
+    else if (m_use_prefixes && m_separator != "")
+    {
+        //every prefix of the name, up to the last separator, is an area
+        size_t start = 0;
+        size_t cut = name.find(m_separator);
+        while (cut != string::npos)
+        {
+            if (cut > start)
+                path += (path == "" ? "" : "/") + name.substr(start, cut - start);
+            start = cut + m_separator.size();
+            cut = name.find(m_separator, start);
+        }
+    }
+
+    int area = path == "" ? 0 : node(path);
+    if (m_area_of.size() <= id)
+        m_area_of.resize(id + 1, -1);
+    m_area_of[id] = area;
+    m_nodes[area].ids.push_back(id);
+}
+
+/****************************************************************/
+bool AreaIndex::resolve(const string& area, vector<int>& nodes) const
+{
+    //an area is given by its full path or just by its name: "kitchen" matches every kitchen of the building
+    nodes.clear();
+    auto it = m_by_path.find(area);
+    if (it != m_by_path.end())
+    {
+        nodes.push_back(it->second);
+        return true;
+    }
+
+    auto range = m_by_name.equal_range(area);
+    for (auto n = range.first; n != range.second; ++n)
+        nodes.push_back(n->second);
+    return !nodes.empty();
+}
+
+/****************************************************************/
+bool AreaIndex::contains(const vector<int>& nodes, size_t id) const
+{
+    if (id >= m_area_of.size())
+        return false;
+
+    for (int area = m_area_of[id]; area >= 0; area = m_nodes[area].parent)
+    {
+        for (int n : nodes)
+        {
+            if (n == area)
+                return true;
+        }
+    }
+    return false;
+}
+
+/****************************************************************/
+void AreaIndex::locations(const vector<int>& nodes, vector<size_t>& ids) const
+{
+    ids.clear();
+    vector<int> stack(nodes.begin(), nodes.end());
+    vector<bool> visited(m_nodes.size(), false);
+    while (!stack.empty())
+    {
+        int n = stack.back();
+        stack.pop_back();
+        if (visited[n])
+            continue;
+        visited[n] = true;
+
+        ids.insert(ids.end(), m_nodes[n].ids.begin(), m_nodes[n].ids.end());
+        stack.insert(stack.end(), m_nodes[n].children.begin(), m_nodes[n].children.end());
+    }
+}
+
+/****************************************************************/
+int AreaIndex::areaOf(size_t id) const
+{
+    return id < m_area_of.size() ? m_area_of[id] : -1;
+}
+
+/****************************************************************/
+const vector<int>& AreaIndex::areaOfAll() const
+{
+    return m_area_of;
+}
+
+/****************************************************************/
+size_t AreaIndex::size() const
+{
+    return m_nodes.size();
+}
+
+/****************************************************************/
+const AreaNode& AreaIndex::at(int node) const
+{
+    return m_nodes[node];
+}
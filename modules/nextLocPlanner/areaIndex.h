@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef AREA_INDEX_H
+#define AREA_INDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+struct AreaNode
+{
+    string          name;       //last element of the path, e.g. "kitchen"
+    string          path;       //full path from the root, e.g. "building1/floor2/kitchen"
+    int             parent;
+    vector<int>     children;
+    vector<size_t>  ids;        //locations belonging directly to this area (not to one of its sub-areas)
+};
+
+/**
+ * Hierarchy of the areas of the map (building, floor, room ...) stored as a prefix tree of area paths.
+ * The area of a location is taken from the configuration, if listed there, otherwise from the prefixes of its name:
+ * with separator "_" the location "floor2_kitchen_table" belongs to the area "floor2/kitchen", which is inside "floor2".
+ * Node 0 is the root, holding the locations without any area.
+ */
+class AreaIndex
+{
+private:
+    vector<AreaNode>                    m_nodes;
+    unordered_map<string, int>          m_by_path;
+    unordered_multimap<string, int>     m_by_name;
+    unordered_map<string, string>       m_assigned;     //location name -> area path, from the configuration
+    vector<int>                         m_area_of;      //location id -> area node
+    string                              m_separator;
+    bool                                m_use_prefixes;
+
+    int     node(const string& path);
+
+public:
+    AreaIndex();
+    ~AreaIndex() = default;
+
+    void    setSeparator(const string& separator);
+    void    useNamePrefixes(bool use);
+    void    assign(const string& location_name, const string& path);
+    void    addLocation(size_t id, const string& name);
+    void    clear();
+
+    bool    resolve(const string& area, vector<int>& nodes) const;
+    bool    contains(const vector<int>& nodes, size_t id) const;
+    void    locations(const vector<int>& nodes, vector<size_t>& ids) const;
+    int     areaOf(size_t id) const;
+
+    const vector<int>&  areaOfAll() const;
+    size_t              size() const;
+    const AreaNode&     at(int node) const;
+};
+
+#endif
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <yarp/os/Time.h>
+#include <random>
+#include "fakeNavigation2D.h"
+
+using namespace yarp::os;
+
+/****************************************************************/
+FakeNavigation2D::FakeNavigation2D() :
+    m_latency(0.0)
+{
+}
+
+/****************************************************************/
+bool FakeNavigation2D::rpc(const string& name)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_calls[name]++;
+    }
+    if (m_latency > 0)
+        Time::delay(m_latency);
+    return true;
+}
+
+/****************************************************************/
+void FakeNavigation2D::generate(size_t n_locations, size_t size_cells, double resolution, unsigned int seed)
+{
+    //square map divided in rooms by walls, with a door in the middle of each wall
+    const size_t room = 40;
+    m_map = MapGrid2D();
+    m_map.setMapName("benchmark_map");
+    m_map.setSize_in_cells(size_cells, size_cells);
+    m_map.setResolution(resolution);
+    m_map.setOrigin(0.0, 0.0, 0.0);
+    for (size_t y = 0; y < size_cells; y++)
+    {
+        for (size_t x = 0; x < size_cells; x++)
+        {
+            bool wall = (x % room == 0 && (y % room) != room / 2) || (y % room == 0 && (x % room) != room / 2);
+            wall = wall || x == 0 || y == 0 || x == size_cells - 1 || y == size_cells - 1;
+            m_map.setMapFlag(XYCell(x, y), wall ? MapGrid2D::MAP_CELL_WALL : MapGrid2D::MAP_CELL_FREE);
+        }
+    }
+
+    //locations at random free cells, named after their room so that the name prefixes work as areas
+    m_locations.clear();
+    mt19937 gen(seed);
+    uniform_int_distribution<size_t> coord(1, size_cells - 2);
+    uniform_real_distribution<double> angle(-180.0, 180.0);
+    while (m_locations.size() < n_locations)
+    {
+        XYCell cell(coord(gen), coord(gen));
+        if (!m_map.isFree(cell))
+            continue;
+
+        XYWorld world = m_map.cell2World(cell);
+        Map2DLocation loc;
+        loc.map_id = m_map.getMapName();
+        loc.x = world.x;
+        loc.y = world.y;
+        loc.theta = angle(gen);
+        string name = "room" + to_string(cell.x / room) + "x" + to_string(cell.y / room) + "_loc" + to_string(m_locations.size());
+        m_locations[name] = loc;
+    }
+
+    setRobotPose(size_cells * resolution / 2, size_cells * resolution / 2, 0.0);
+}
+
+/****************************************************************/
+void FakeNavigation2D::setRobotPose(double x, double y, double theta)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_robot.map_id = m_map.getMapName();
+    m_robot.x = x;
+    m_robot.y = y;
+    m_robot.theta = theta;
+}
+
+/****************************************************************/
+void FakeNavigation2D::setLatency(double latency)
+{
+    m_latency = latency;
+}
+
+/****************************************************************/
+void FakeNavigation2D::resetCalls()
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_calls.clear();
+}
+
+/****************************************************************/
+size_t FakeNavigation2D::calls() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    size_t total {0};
+    for (const auto& c : m_calls)
+        total += c.second;
+    return total;
+}
+
+/****************************************************************/
+map<string, size_t> FakeNavigation2D::callsByMethod() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_calls;
+}
+
+/****************************************************************/
+vector<string> FakeNavigation2D::locationNames() const
+{
+    vector<string> names;
+    for (const auto& l : m_locations)
+        names.push_back(l.first);
+    return names;
+}
+
+/****************************************************************/
+bool FakeNavigation2D::getCurrentNavigationMap(NavigationMapTypeEnum map_type, MapGrid2D& map)
+{
+    rpc("getCurrentNavigationMap");
+    map = m_map;
+    return true;
+}
+
+/****************************************************************/
+bool FakeNavigation2D::storeLocation(std::string location_name, Map2DLocation loc)
+{
+    rpc("storeLocation");
+    m_locations[location_name] = loc;
+    return true;
+}
+
+/****************************************************************/
+bool FakeNavigation2D::getLocation(std::string location_name, Map2DLocation& loc)
+{
+    rpc("getLocation");
+    auto it = m_locations.find(location_name);
+    if (it == m_locations.end())
+        return false;
+
+    loc = it->second;
+    return true;
+}
+
+/****************************************************************/
+bool FakeNavigation2D::getLocationsList(std::vector<std::string>& locations)
+{
+    rpc("getLocationsList");
+    locations = locationNames();
+    return true;
+}
+
+/****************************************************************/
+bool FakeNavigation2D::getAllLocations(std::vector<Map2DLocation>& locations)
+{
+    rpc("getAllLocations");
+    locations.clear();
+    for (const auto& l : m_locations)
+        locations.push_back(l.second);
+    return true;
+}
+
+/****************************************************************/
+bool FakeNavigation2D::deleteLocation(std::string location_name)
+{
+    rpc("deleteLocation");
+    return m_locations.erase(location_name) > 0;
+}
+
+/****************************************************************/
+bool FakeNavigation2D::clearAllLocations()
+{
+    rpc("clearAllLocations");
+    m_locations.clear();
+    return true;
+}
+
+/****************************************************************/
+bool FakeNavigation2D::getCurrentPosition(Map2DLocation& loc)
+{
+    rpc("getCurrentPosition");
+    lock_guard<mutex> lock(m_mutex);
+    loc = m_robot;
+    return true;
+}
+
+/****************************************************************/
+bool FakeNavigation2D::getCurrentPosition(Map2DLocation& loc, yarp::sig::Matrix& cov)
+{
+    return getCurrentPosition(loc);
+}
+
+/****************************************************************/
+bool FakeNavigation2D::getLocalizationStatus(LocalizationStatusEnum& status)
+{
+    rpc("getLocalizationStatus");
+    status = LocalizationStatusEnum::localization_status_localized_ok;
+    return true;
+}
+
+/****************************************************************/
+bool FakeNavigation2D::getEstimatedPoses(std::vector<Map2DLocation>& poses)
+{
+    rpc("getEstimatedPoses");
+    lock_guard<mutex> lock(m_mutex);
+    poses.assign(1, m_robot);
+    return true;
+}
+
+/****************************************************************/
+bool FakeNavigation2D::setInitialPose(const Map2DLocation& loc)
+{
+    rpc("setInitialPose");
+    lock_guard<mutex> lock(m_mutex);
+    m_robot = loc;
+    return true;
+}
+
+/****************************************************************/
+bool FakeNavigation2D::setInitialPose(const Map2DLocation& loc, const yarp::sig::Matrix& cov)
+{
+    return setInitialPose(loc);
+}
+
+/****************************************************************/
+bool FakeNavigation2D::getNavigationStatus(NavigationStatusEnum& status)
+{
+    rpc("getNavigationStatus");
+    status = NavigationStatusEnum::navigation_status_idle;
+    return true;
+}
+
+//the planner does not move the robot: the remaining methods are only counted
+bool FakeNavigation2D::gotoTargetByAbsoluteLocation(Map2DLocation loc) { return !rpc("gotoTargetByAbsoluteLocation"); }
+bool FakeNavigation2D::followPath(const Map2DPath& path) { return !rpc("followPath"); }
+bool FakeNavigation2D::gotoTargetByRelativeLocation(double x, double y, double theta) { return !rpc("gotoTargetByRelativeLocation"); }
+bool FakeNavigation2D::gotoTargetByRelativeLocation(double x, double y) { return !rpc("gotoTargetByRelativeLocation"); }
+bool FakeNavigation2D::applyVelocityCommand(double x_vel, double y_vel, double theta_vel, double timeout) { return !rpc("applyVelocityCommand"); }
+bool FakeNavigation2D::getAbsoluteLocationOfCurrentTarget(Map2DLocation& loc) { return !rpc("getAbsoluteLocationOfCurrentTarget"); }
+bool FakeNavigation2D::getRelativeLocationOfCurrentTarget(double& x, double& y, double& theta) { return !rpc("getRelativeLocationOfCurrentTarget"); }
+bool FakeNavigation2D::getLastVelocityCommand(double& x_vel, double& y_vel, double& theta_vel) { return !rpc("getLastVelocityCommand"); }
+bool FakeNavigation2D::stopNavigation() { return rpc("stopNavigation"); }
+bool FakeNavigation2D::suspendNavigation(const double time_s) { return rpc("suspendNavigation"); }
+bool FakeNavigation2D::resumeNavigation() { return rpc("resumeNavigation"); }
+bool FakeNavigation2D::recomputeCurrentNavigationPath() { return !rpc("recomputeCurrentNavigationPath"); }
+bool FakeNavigation2D::getAllNavigationWaypoints(TrajectoryTypeEnum trajectory_type, Map2DPath& waypoints) { return !rpc("getAllNavigationWaypoints"); }
+bool FakeNavigation2D::getCurrentNavigationWaypoint(Map2DLocation& curr_waypoint) { return !rpc("getCurrentNavigationWaypoint"); }
+bool FakeNavigation2D::gotoTargetByLocationName(std::string location_name) { return !rpc("gotoTargetByLocationName"); }
+bool FakeNavigation2D::checkInsideArea(Map2DArea area) { return !rpc("checkInsideArea"); }
+bool FakeNavigation2D::checkInsideArea(std::string area_name) { return !rpc("checkInsideArea"); }
+bool FakeNavigation2D::checkNearToLocation(Map2DLocation loc, double linear_tolerance, double angular_tolerance) { return !rpc("checkNearToLocation"); }
+bool FakeNavigation2D::checkNearToLocation(std::string location_name, double linear_tolerance, double angular_tolerance) { return !rpc("checkNearToLocation"); }
+bool FakeNavigation2D::getNameOfCurrentTarget(std::string& location_name) { return !rpc("getNameOfCurrentTarget"); }
+bool FakeNavigation2D::storeCurrentPosition(std::string location_name) { return !rpc("storeCurrentPosition"); }
+bool FakeNavigation2D::storeArea(std::string area_name, Map2DArea area) { return !rpc("storeArea"); }
+bool FakeNavigation2D::storePath(std::string path_name, Map2DPath path) { return !rpc("storePath"); }
+bool FakeNavigation2D::getArea(std::string area_name, Map2DArea& area) { return !rpc("getArea"); }
+bool FakeNavigation2D::getPath(std::string path_name, Map2DPath& path) { return !rpc("getPath"); }
+bool FakeNavigation2D::getAreasList(std::vector<std::string>& areas) { areas.clear(); return rpc("getAreasList"); }
+bool FakeNavigation2D::getPathsList(std::vector<std::string>& paths) { paths.clear(); return rpc("getPathsList"); }
+bool FakeNavigation2D::getAllAreas(std::vector<Map2DArea>& areas) { areas.clear(); return rpc("getAllAreas"); }
+bool FakeNavigation2D::getAllPaths(std::vector<Map2DPath>& paths) { paths.clear(); return rpc("getAllPaths"); }
+bool FakeNavigation2D::renameLocation(std::string original_name, std::string new_name) { return !rpc("renameLocation"); }
+bool FakeNavigation2D::renameArea(std::string original_name, std::string new_name) { return !rpc("renameArea"); }
+bool FakeNavigation2D::renamePath(std::string original_name, std::string new_name) { return !rpc("renamePath"); }
+bool FakeNavigation2D::deleteArea(std::string area_name) { return !rpc("deleteArea"); }
+bool FakeNavigation2D::deletePath(std::string path_name) { return !rpc("deletePath"); }
+bool FakeNavigation2D::clearAllAreas() { return rpc("clearAllAreas"); }
+bool FakeNavigation2D::clearAllPaths() { return rpc("clearAllPaths"); }
+bool FakeNavigation2D::clearAllMapsTemporaryFlags() { return rpc("clearAllMapsTemporaryFlags"); }
+bool FakeNavigation2D::clearTemporaryFlags(std::string map_name) { return rpc("clearTemporaryFlags"); }
+bool FakeNavigation2D::getEstimatedOdometry(OdometryData& odom) { return !rpc("getEstimatedOdometry"); }
+bool FakeNavigation2D::startLocalizationService() { return rpc("startLocalizationService"); }
+bool FakeNavigation2D::stopLocalizationService() { return rpc("stopLocalizationService"); }
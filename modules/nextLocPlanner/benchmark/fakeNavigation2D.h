@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef FAKE_NAVIGATION_2D_H
+#define FAKE_NAVIGATION_2D_H
+
+#include <yarp/dev/INavigation2D.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <yarp/dev/OdometryData.h>
+#include <yarp/sig/Matrix.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace std;
+
+/**
+ * In-process INavigation2D serving a synthetic map and its locations, used to benchmark the planner without any navigation server.
+ * Every call is counted as one RPC and can be slowed down by a simulated round trip latency.
+ * The call counters and the robot pose are guarded by a mutex, since the planner queries the fake from its own thread.
+ */
+class FakeNavigation2D : public INavigation2D
+{
+private:
+    MapGrid2D                       m_map;
+    map<string, Map2DLocation>      m_locations;
+    Map2DLocation                   m_robot;
+    map<string, size_t>             m_calls;
+    double                          m_latency;
+    mutable std::mutex              m_mutex;
+
+    bool    rpc(const string& name);
+
+public:
+    FakeNavigation2D();
+    ~FakeNavigation2D() override = default;
+
+    void    generate(size_t n_locations, size_t size_cells, double resolution, unsigned int seed);
+    void    setRobotPose(double x, double y, double theta);
+    void    setLatency(double latency);
+    void    resetCalls();
+    size_t  calls() const;
+    map<string, size_t> callsByMethod() const;
+    vector<string> locationNames() const;
+
+    //INavigation2DTargetActions
+    bool gotoTargetByAbsoluteLocation(Map2DLocation loc) override;
+    bool followPath(const Map2DPath& path) override;
+    bool gotoTargetByRelativeLocation(double x, double y, double theta) override;
+    bool gotoTargetByRelativeLocation(double x, double y) override;
+    bool applyVelocityCommand(double x_vel, double y_vel, double theta_vel, double timeout = 0.1) override;
+    bool getAbsoluteLocationOfCurrentTarget(Map2DLocation& loc) override;
+    bool getRelativeLocationOfCurrentTarget(double& x, double& y, double& theta) override;
+    bool getLastVelocityCommand(double& x_vel, double& y_vel, double& theta_vel) override;
+
+    //INavigation2DControlActions
+    bool getNavigationStatus(NavigationStatusEnum& status) override;
+    bool stopNavigation() override;
+    bool suspendNavigation(const double time_s) override;
+    bool resumeNavigation() override;
+    bool recomputeCurrentNavigationPath() override;
+    bool getAllNavigationWaypoints(TrajectoryTypeEnum trajectory_type, Map2DPath& waypoints) override;
+    bool getCurrentNavigationWaypoint(Map2DLocation& curr_waypoint) override;
+    bool getCurrentNavigationMap(NavigationMapTypeEnum map_type, MapGrid2D& map) override;
+
+    //INavigation2DExtraActions
+    bool gotoTargetByLocationName(std::string location_name) override;
+    bool checkInsideArea(Map2DArea area) override;
+    bool checkInsideArea(std::string area_name) override;
+    bool checkNearToLocation(Map2DLocation loc, double linear_tolerance, double angular_tolerance) override;
+    bool checkNearToLocation(std::string location_name, double linear_tolerance, double angular_tolerance) override;
+    bool getNameOfCurrentTarget(std::string& location_name) override;
+    bool storeCurrentPosition(std::string location_name) override;
+    bool storeLocation(std::string location_name, Map2DLocation loc) override;
+    bool storeArea(std::string area_name, Map2DArea area) override;
+    bool storePath(std::string path_name, Map2DPath path) override;
+    bool getLocation(std::string location_name, Map2DLocation& loc) override;
+    bool getArea(std::string area_name, Map2DArea& area) override;
+    bool getPath(std::string path_name, Map2DPath& path) override;
+    bool getLocationsList(std::vector<std::string>& locations) override;
+    bool getAreasList(std::vector<std::string>& areas) override;
+    bool getPathsList(std::vector<std::string>& paths) override;
+    bool getAllLocations(std::vector<Map2DLocation>& locations) override;
+    bool getAllAreas(std::vector<Map2DArea>& areas) override;
+    bool getAllPaths(std::vector<Map2DPath>& paths) override;
+    bool renameLocation(std::string original_name, std::string new_name) override;
+    bool renameArea(std::string original_name, std::string new_name) override;
+    bool renamePath(std::string original_name, std::string new_name) override;
+    bool deleteLocation(std::string location_name) override;
+    bool deleteArea(std::string area_name) override;
+    bool deletePath(std::string path_name) override;
+    bool clearAllLocations() override;
+    bool clearAllAreas() override;
+    bool clearAllPaths() override;
+    bool clearAllMapsTemporaryFlags() override;
+    bool clearTemporaryFlags(std::string map_name) override;
+
+    //ILocalization2D
+    bool getLocalizationStatus(LocalizationStatusEnum& status) override;
+    bool getEstimatedPoses(std::vector<Map2DLocation>& poses) override;
+    bool getCurrentPosition(Map2DLocation& loc) override;
+    bool getCurrentPosition(Map2DLocation& loc, yarp::sig::Matrix& cov) override;
+    bool getEstimatedOdometry(OdometryData& odom) override;
+    bool setInitialPose(const Map2DLocation& loc) override;
+    bool setInitialPose(const Map2DLocation& loc, const yarp::sig::Matrix& cov) override;
+    bool startLocalizationService() override;
+    bool stopLocalizationService() override;
+};
+
+#endif
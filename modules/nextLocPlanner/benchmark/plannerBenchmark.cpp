@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <yarp/os/Network.h>
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Bottle.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <random>
+
+#include "../nextLocPlanner.h"
+#include "fakeNavigation2D.h"
+
+using namespace std;
+using namespace yarp::os;
+
+/**
+ * Times the hot path of NextLocPlanner against a FakeNavigation2D serving synthetic maps with an increasing number of locations.
+ * The results are written as JSON, one entry per number of locations, with the time in milliseconds and the navigation RPCs of each phase.
+ */
+
+struct Phase
+{
+    string  name;
+    double  ms;
+    size_t  rpcs;
+    size_t  repetitions;
+};
+
+class Stopwatch
+{
+private:
+    chrono::steady_clock::time_point    m_start;
+    FakeNavigation2D&                   m_nav;
+
+public:
+    Stopwatch(FakeNavigation2D& nav) : m_nav(nav)
+    {
+        m_nav.resetCalls();
+        m_start = chrono::steady_clock::now();
+    }
+
+    Phase stop(const string& name, size_t repetitions = 1)
+    {
+        Phase phase;
+        phase.name = name;
+        phase.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - m_start).count();
+        phase.rpcs = m_nav.calls();
+        phase.repetitions = repetitions;
+        return phase;
+    }
+};
+
+/****************************************************************/
+static bool configurePlanner(NextLocPlanner& planner, size_t n, const string& extra_options)
+{
+    //the planner is configured from the command line only, without any .ini file
+    string options = "--rpcPort /nextLocPlannerBenchmark/rpc" + to_string(n) +
+                     " --localization_port_local /nextLocPlannerBenchmark/localization" + to_string(n) + ":i" +
+                     " --persist_state false " + extra_options;
+    vector<string> tokens {"nextLocPlannerBenchmark"};
+    istringstream stream(options);
+    for (string token; stream >> token; )
+        tokens.push_back(token);
+    vector<char*> argv;
+    for (string& token : tokens)
+        argv.push_back(&token[0]);
+
+    ResourceFinder rf;
+    rf.configure((int)argv.size(), argv.data());
+    return planner.configure(rf);
+}
+
+/****************************************************************/
+static void runBenchmark(size_t n, ResourceFinder& args, vector<Phase>& phases)
+{
+    size_t mapCells = args.check("map_cells") ? args.find("map_cells").asInt32() : 400;
+    double resolution = args.check("resolution") ? args.find("resolution").asFloat64() : 0.05;
+    size_t repetitions = args.check("repetitions") ? args.find("repetitions").asInt32() : 20;
+    size_t storm = args.check("set_storm") ? args.find("set_storm").asInt32() : 200;
+    string plannerOptions = args.check("planner_options") ? args.find("planner_options").asString() : "";
+
+    FakeNavigation2D nav;
+    nav.generate(n, mapCells, resolution, (unsigned int)n);
+    if (args.check("latency"))
+        nav.setLatency(args.find("latency").asFloat64());
+    vector<string> names = nav.locationNames();
+    double side = mapCells * resolution;
+
+    NextLocPlanner planner;
+    planner.setNavigation(&nav);
+    {
+        Stopwatch sw(nav);
+        if (!configurePlanner(planner, n, plannerOptions))
+        {
+            cerr << "configure failed with " << n << " locations" << endl;
+            return;
+        }
+        phases.push_back(sw.stop("configure"));
+    }
+
+    //ranking after the robot moved: updateModule notices the motion, the ranking is done when asked
+    mt19937 gen((unsigned int)n);
+    uniform_real_distribution<double> coord(0.1 * side, 0.9 * side);
+    {
+        Stopwatch sw(nav);
+        for (size_t i = 0; i < repetitions; i++)
+        {
+            nav.setRobotPose(coord(gen), coord(gen), 0.0);
+            planner.updateModule();
+            planner.sortUncheckedLocations();
+        }
+        phases.push_back(sw.stop("sortUncheckedLocations", repetitions));
+    }
+
+    Bottle cmd, reply;
+    {
+        Stopwatch sw(nav);
+        for (size_t i = 0; i < repetitions; i++)
+        {
+            cmd.fromString("next");
+            planner.respond(cmd, reply);
+        }
+        phases.push_back(sw.stop("next", repetitions));
+    }
+
+    {
+        Stopwatch sw(nav);
+        for (size_t i = 0; i < repetitions; i++)
+        {
+            cmd.fromString("list");
+            planner.respond(cmd, reply);
+        }
+        phases.push_back(sw.stop("list", repetitions));
+    }
+
+    //many status changes in a row, as sent by the orchestrator, followed by the next request which pays for the ranking
+    {
+        uniform_int_distribution<size_t> pick(0, names.size() - 1);
+        Stopwatch sw(nav);
+        for (size_t i = 0; i < storm; i++)
+        {
+            cmd.fromString("set " + names[pick(gen)] + (i % 2 ? " checked" : " unchecked"));
+            planner.respond(cmd, reply);
+        }
+        cmd.fromString("next");
+        planner.respond(cmd, reply);
+        phases.push_back(sw.stop("set_storm", storm));
+    }
+
+    planner.close();
+}
+
+/****************************************************************/
+int main(int argc, char *argv[])
+{
+    //everything runs in this process: no yarpserver is needed
+    Network yarp;
+    Network::setLocalMode(true);
+
+    ResourceFinder args;
+    args.configure(argc, argv);
+
+    vector<size_t> sizes {10, 100, 1000, 10000};
+    if (args.check("locations") && args.find("locations").isList())
+    {
+        sizes.clear();
+        Bottle* list = args.find("locations").asList();
+        for (size_t i = 0; i < list->size(); i++)
+            sizes.push_back(list->get(i).asInt32());
+    }
+
+    ostringstream json;
+    json << "{\n  \"benchmark\": \"nextLocPlanner\",\n  \"results\": [";
+    for (size_t s = 0; s < sizes.size(); s++)
+    {
+        vector<Phase> phases;
+        runBenchmark(sizes[s], args, phases);
+
+        json << (s ? "," : "") << "\n    {\"locations\": " << sizes[s] << ", \"phases\": [";
+        for (size_t p = 0; p < phases.size(); p++)
+        {
+            json << (p ? "," : "") << "\n      {\"name\": \"" << phases[p].name << "\", \"repetitions\": " << phases[p].repetitions
+                 << ", \"total_ms\": " << phases[p].ms << ", \"ms_per_repetition\": " << phases[p].ms / phases[p].repetitions
+                 << ", \"navigation_rpcs\": " << phases[p].rpcs << "}";
+        }
+        json << "\n    ]}";
+    }
+    json << "\n  ]\n}\n";
+
+    if (args.check("output"))
+    {
+        ofstream out(args.find("output").asString());
+        out << json.str();
+    }
+    else
+        cout << json.str();
+
+    return 0;
+}
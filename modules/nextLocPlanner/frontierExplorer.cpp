@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <math.h>
+#include <cstdint>
+#include <algorithm>
+#include "frontierExplorer.h"
+
+#define CELL_FREE       0
+#define CELL_UNKNOWN    1
+#define CELL_OCCUPIED   2
+
+/****************************************************************/
+FrontierExplorer::FrontierExplorer() :
+    m_min_size(5),
+    m_gain_radius(2.0)
+{
+}
+
+/****************************************************************/
+void FrontierExplorer::setMinSize(size_t cells)
+{
+    m_min_size = max((size_t)1, cells);
+}
+
+/****************************************************************/
+void FrontierExplorer::setGainRadius(double radius)
+{
+    m_gain_radius = radius;
+}
+
+/****************************************************************/
+bool FrontierExplorer::extract(const MapGrid2D& map, vector<Frontier>& frontiers) const
+{
+    frontiers.clear();
+    size_t width = map.width();
+    size_t height = map.height();
+    double resolution {0.0};
+    map.getResolution(resolution);
+    if (width == 0 || height == 0 || resolution <= 0)
+        return false;
+
+    //the flags are read once, so that the searches below do not query the map
+    vector<uint8_t> cells(width * height, CELL_OCCUPIED);
+    for (size_t y = 0; y < height; y++)
+    {
+        for (size_t x = 0; x < width; x++)
+        {
+            MapGrid2D::map_flags flag;
+            if (!map.getMapFlag(XYCell(x, y), flag))
+                continue;
+            if (flag == MapGrid2D::MAP_CELL_FREE || flag == MapGrid2D::MAP_CELL_GOAL)
+                cells[y * width + x] = CELL_FREE;
+            else if (flag == MapGrid2D::MAP_CELL_UNKNOWN)
+                cells[y * width + x] = CELL_UNKNOWN;
+        }
+    }
+
+    auto isFrontier = [&](size_t x, size_t y)
+    {
+        if (cells[y * width + x] != CELL_FREE)
+            return false;
+        return (x > 0 && cells[y * width + x - 1] == CELL_UNKNOWN) || (x + 1 < width && cells[y * width + x + 1] == CELL_UNKNOWN) ||
+               (y > 0 && cells[(y - 1) * width + x] == CELL_UNKNOWN) || (y + 1 < height && cells[(y + 1) * width + x] == CELL_UNKNOWN);
+    };
+
+    //clusters of 8-connected frontier cells
+    vector<bool> visited(width * height, false);
+    vector<size_t> cluster, queue;
+    int radius = max(1, (int)ceil(m_gain_radius / resolution));
+    for (size_t start = 0; start < width * height; start++)
+    {
+        if (visited[start] || !isFrontier(start % width, start / width))
+            continue;
+
+        cluster.clear();
+        queue.assign(1, start);
+        visited[start] = true;
+        while (!queue.empty())
+        {
+            size_t c = queue.back();
+            queue.pop_back();
+            cluster.push_back(c);
+            long cx = (long)(c % width), cy = (long)(c / width);
+            for (long dy = -1; dy <= 1; dy++)
+            {
+                for (long dx = -1; dx <= 1; dx++)
+                {
+                    long nx = cx + dx, ny = cy + dy;
+                    if (nx < 0 || ny < 0 || nx >= (long)width || ny >= (long)height)
+                        continue;
+                    size_t n = (size_t)ny * width + (size_t)nx;
+                    if (!visited[n] && isFrontier((size_t)nx, (size_t)ny))
+                    {
+                        visited[n] = true;
+                        queue.push_back(n);
+                    }
+                }
+            }
+        }
+        if (cluster.size() < m_min_size)
+            continue;
+
+        //the target is the frontier cell closest to the centroid, which may not belong to the cluster if it is curved
+        double mx {0.0}, my {0.0};
+        for (size_t c : cluster)
+        {
+            mx += c % width;
+            my += c / width;
+        }
+        mx /= cluster.size();
+        my /= cluster.size();
+        size_t target = *min_element(cluster.begin(), cluster.end(), [&](size_t a, size_t b)
+            {
+                return pow(a % width - mx, 2) + pow(a / width - my, 2) < pow(b % width - mx, 2) + pow(b / width - my, 2);
+            });
+
+        //information gain: unknown cells around the target, whose mean direction gives the orientation of the robot
+        long tx = (long)(target % width), ty = (long)(target / width);
+        XYWorld targetWorld = map.cell2World(XYCell(tx, ty));
+        size_t unknown {0};
+        double dirX {0.0}, dirY {0.0};
+        for (long dy = -radius; dy <= radius; dy++)
+        {
+            for (long dx = -radius; dx <= radius; dx++)
+            {
+                long nx = tx + dx, ny = ty + dy;
+                if (nx < 0 || ny < 0 || nx >= (long)width || ny >= (long)height || dx * dx + dy * dy > radius * radius)
+                    continue;
+                if (cells[(size_t)ny * width + (size_t)nx] != CELL_UNKNOWN)
+                    continue;
+                XYWorld w = map.cell2World(XYCell(nx, ny));
+                dirX += w.x - targetWorld.x;
+                dirY += w.y - targetWorld.y;
+                unknown++;
+            }
+        }
+
+        Frontier frontier;
+        frontier.pose.map_id = map.getMapName();
+        frontier.pose.x = targetWorld.x;
+        frontier.pose.y = targetWorld.y;
+        frontier.pose.theta = atan2(dirY, dirX) * 180.0 / M_PI;
+        frontier.size = cluster.size();
+        frontier.gain = unknown * resolution * resolution;
+        frontiers.push_back(frontier);
+    }
+
+    return true;
+}
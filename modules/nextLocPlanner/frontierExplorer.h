@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef FRONTIER_EXPLORER_H
+#define FRONTIER_EXPLORER_H
+
+#include <yarp/dev/INavigation2D.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <vector>
+
+using namespace yarp::dev::Nav2D;
+using namespace std;
+
+struct Frontier
+{
+    Map2DLocation   pose;       //free cell of the frontier closest to its centroid, facing the unknown cells around it
+    size_t          size;       //number of frontier cells
+    double          gain;       //unknown area (square meters) within the gain radius from the pose
+};
+
+/**
+ * Frontiers between the known-free and the unknown cells of a navigation map, used as search locations when the map has none.
+ * A frontier cell is a free cell with an unknown 4-neighbour. The frontier cells are grouped in 8-connected clusters, and the
+ * clusters smaller than a minimum size are dropped as noise. The information gain of a frontier is the unknown area around it.
+ */
+class FrontierExplorer
+{
+private:
+    size_t  m_min_size;
+    double  m_gain_radius;
+
+public:
+    FrontierExplorer();
+    ~FrontierExplorer() = default;
+
+    void    setMinSize(size_t cells);
+    void    setGainRadius(double radius);
+
+    bool    extract(const MapGrid2D& map, vector<Frontier>& frontiers) const;
+};
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "leaseTable.h"
+
+/****************************************************************/
+LeaseTable::LeaseTable() :
+    m_ttl(60.0)
+{
+}
+
+/****************************************************************/
+void LeaseTable::setTtl(double ttl)
+{
+    m_ttl = ttl;
+}
+
+/****************************************************************/
+double LeaseTable::ttl() const
+{
+    return m_ttl;
+}
+
+/****************************************************************/
+void LeaseTable::reserve(const string& client, size_t id, double now)
+{
+    //a client works on one location at a time and a location is reserved by one client at a time
+    releaseClient(client);
+    releaseLocation(id);
+
+    Lease lease;
+    lease.client = client;
+    lease.id = id;
+    lease.expiry = now + m_ttl;
+    m_by_client[client] = lease;
+    m_by_location[id] = client;
+}
+
+/****************************************************************/
+bool LeaseTable::renew(const string& client, double now)
+{
+    auto it = m_by_client.find(client);
+    if (it == m_by_client.end())
+        return false;
+
+    it->second.expiry = now + m_ttl;
+    return true;
+}
+
+/****************************************************************/
+bool LeaseTable::releaseClient(const string& client)
+{
+    auto it = m_by_client.find(client);
+    if (it == m_by_client.end())
+        return false;
+
+    m_by_location.erase(it->second.id);
+    m_by_client.erase(it);
+    return true;
+}
+
+/****************************************************************/
+bool LeaseTable::releaseLocation(size_t id)
+{
+    auto it = m_by_location.find(id);
+    if (it == m_by_location.end())
+        return false;
+
+    m_by_client.erase(it->second);
+    m_by_location.erase(it);
+    return true;
+}
+
+/****************************************************************/
+void LeaseTable::clear()
+{
+    m_by_client.clear();
+    m_by_location.clear();
+}
+
+/****************************************************************/
+void LeaseTable::expire(double now, vector<size_t>& expired_ids)
+{
+    expired_ids.clear();
+    for (auto it = m_by_client.begin(); it != m_by_client.end(); )
+    {
+        if (it->second.expiry < now)
+        {
+            expired_ids.push_back(it->second.id);
+            m_by_location.erase(it->second.id);
+            it = m_by_client.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+/****************************************************************/
+bool LeaseTable::owner(size_t id, string& client) const
+{
+    auto it = m_by_location.find(id);
+    if (it == m_by_location.end())
+        return false;
+
+    client = it->second;
+    return true;
+}
+
+/****************************************************************/
+bool LeaseTable::empty() const
+{
+    return m_by_client.empty();
+}
+
+/****************************************************************/
+const unordered_map<string, Lease>& LeaseTable::leases() const
+{
+    return m_by_client;
+}
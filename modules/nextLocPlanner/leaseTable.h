@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LEASE_TABLE_H
+#define LEASE_TABLE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+using namespace std;
+
+struct Lease
+{
+    string  client;
+    size_t  id;         //id of the reserved location in the LocationTable
+    double  expiry;
+};
+
+/**
+ * Reservations of the locations handed out by the planner when several robots share it.
+ * Each client holds at most one lease, which expires after a time-to-live unless it is renewed by a heartbeat.
+ */
+class LeaseTable
+{
+private:
+    unordered_map<string, Lease>    m_by_client;
+    unordered_map<size_t, string>   m_by_location;
+    double                          m_ttl;
+
+public:
+    LeaseTable();
+    ~LeaseTable() = default;
+
+    void    setTtl(double ttl);
+    double  ttl() const;
+
+    void    reserve(const string& client, size_t id, double now);
+    bool    renew(const string& client, double now);
+    bool    releaseClient(const string& client);
+    bool    releaseLocation(size_t id);
+    void    clear();
+    void    expire(double now, vector<size_t>& expired_ids);
+
+    bool    owner(size_t id, string& client) const;
+    bool    empty() const;
+    const unordered_map<string, Lease>& leases() const;
+};
+
+#endif
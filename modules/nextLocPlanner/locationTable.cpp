@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <yarp/os/Time.h>
+#include "locationTable.h"
+
+const size_t LocationTable::npos = static_cast<size_t>(-1);
+
+/****************************************************************/
+size_t LocationTable::add(const string& name, const Map2DLocation& pose, bool pose_valid, const string& area, LocationStatus status)
+{
+    auto it = m_index.find(name);
+    if (it != m_index.end())
+    {
+        //already known location: refresh its data and move it to the requested status
+        LocationEntry& entry = m_entries[it->second];
+        if (pose_valid)
+        {
+            entry.pose = pose;
+            entry.pose_valid = true;
+        }
+        setStatus(it->second, status);
+        return it->second;
+    }
+
+    LocationEntry entry;
+    entry.name = name;
+    entry.status = status;
+    entry.pose = pose;
+    entry.pose_valid = pose_valid;
+    entry.area = area;
+    entry.added_time = yarp::os::Time::now();
+    entry.status_time = entry.added_time;
+    entry.slot = 0;
+
+    size_t new_id = m_entries.size();
+    m_entries.push_back(entry);
+    m_index[name] = new_id;
+    attach(new_id, status);
+
+    return new_id;
+}
+
+/****************************************************************/
+size_t LocationTable::id(const string& name) const
+{
+    auto it = m_index.find(name);
+    return it == m_index.end() ? npos : it->second;
+}
+
+/****************************************************************/
+bool LocationTable::contains(const string& name) const
+{
+    return m_index.find(name) != m_index.end();
+}
+
+/****************************************************************/
+size_t LocationTable::size() const
+{
+    return m_entries.size();
+}
+
+/****************************************************************/
+void LocationTable::clear()
+{
+    m_entries.clear();
+    m_index.clear();
+    for (auto& b : m_buckets)
+        b.clear();
+}
+
+/****************************************************************/
+LocationEntry& LocationTable::at(size_t id)
+{
+    return m_entries[id];
+}
+
+/****************************************************************/
+const LocationEntry& LocationTable::at(size_t id) const
+{
+    return m_entries[id];
+}
+
+/****************************************************************/
+void LocationTable::detach(size_t id)
+{
+    //swap with the last element of the bucket to remove it in constant time
+    vector<size_t>& b = m_buckets[m_entries[id].status];
+    size_t slot = m_entries[id].slot;
+    size_t last = b.back();
+    b[slot] = last;
+    m_entries[last].slot = slot;
+    b.pop_back();
+}
+
+/****************************************************************/
+void LocationTable::attach(size_t id, LocationStatus status)
+{
+    vector<size_t>& b = m_buckets[status];
+    m_entries[id].status = status;
+    m_entries[id].slot = b.size();
+    b.push_back(id);
+}
+
+/****************************************************************/
+void LocationTable::setStatus(size_t id, LocationStatus status)
+{
+    LocationEntry& entry = m_entries[id];
+    if (entry.status == status)
+        return;
+
+    detach(id);
+    attach(id, status);
+    entry.status_time = yarp::os::Time::now();
+}
+
+/****************************************************************/
+void LocationTable::setAllStatus(LocationStatus status)
+{
+    //removed locations are left untouched
+    for (int s = 0; s < LOC_REMOVED; s++)
+    {
+        if (s == status)
+            continue;
+        vector<size_t> ids = m_buckets[s];
+        for (size_t id : ids)
+            setStatus(id, status);
+    }
+}
+
+/****************************************************************/
+const vector<size_t>& LocationTable::bucket(LocationStatus status) const
+{
+    return m_buckets[status];
+}
+
+/****************************************************************/
+void LocationTable::reorderBucket(LocationStatus status, const vector<size_t>& ordered_ids)
+{
+    vector<size_t>& b = m_buckets[status];
+    if (ordered_ids.size() != b.size())
+        return;
+
+    b = ordered_ids;
+    for (size_t i = 0; i < b.size(); i++)
+        m_entries[b[i]].slot = i;
+}
+
+/****************************************************************/
+bool LocationTable::parseStatus(const string& str, LocationStatus& status)
+{
+    if (str == "unchecked" || str == "Unchecked" || str == "UNCHECKED")
+        status = LOC_UNCHECKED;
+    else if (str == "checking" || str == "Checking" || str == "CHECKING")
+        status = LOC_CHECKING;
+    else if (str == "checked" || str == "Checked" || str == "CHECKED")
+        status = LOC_CHECKED;
+    else if (str == "blocked" || str == "Blocked" || str == "BLOCKED")
+        status = LOC_BLOCKED;
+    else
+        return false;
+
+    return true;
+}
+
+/****************************************************************/
+bool LocationTable::parseStatusName(const string& str, LocationStatus& status)
+{
+    //inverse of statusName(), removed status included
+    if (str == "removed")
+    {
+        status = LOC_REMOVED;
+        return true;
+    }
+    return parseStatus(str, status);
+}
+
+/****************************************************************/
+string LocationTable::statusName(LocationStatus status)
+{
+    switch (status)
+    {
+    case LOC_UNCHECKED:
+        return "unchecked";
+    case LOC_CHECKING:
+        return "checking";
+    case LOC_CHECKED:
+        return "checked";
+    case LOC_BLOCKED:
+        return "blocked";
+    default:
+        return "removed";
+    }
+}
+
+/****************************************************************/
+string LocationTable::statusLabel(LocationStatus status)
+{
+    switch (status)
+    {
+    case LOC_UNCHECKED:
+        return "Unchecked";
+    case LOC_CHECKING:
+        return "Checking";
+    case LOC_CHECKED:
+        return "Checked";
+    case LOC_BLOCKED:
+        return "Blocked";
+    default:
+        return "NotValid or Removed";
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef LOCATION_TABLE_H
+#define LOCATION_TABLE_H
+
+#include <yarp/dev/INavigation2D.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+using namespace yarp::dev::Nav2D;
+using namespace std;
+
+enum LocationStatus
+{
+    LOC_UNCHECKED = 0,
+    LOC_CHECKING,
+    LOC_CHECKED,
+    LOC_BLOCKED,        //not reachable, skipped until its backoff expires
+    LOC_REMOVED,
+    LOC_STATUS_COUNT
+};
+
+struct LocationEntry
+{
+    string          name;
+    LocationStatus  status;
+    Map2DLocation   pose;
+    bool            pose_valid;
+    string          area;
+    double          added_time;
+    double          status_time;
+    size_t          slot;           //position of the location inside the bucket of its status
+};
+
+/**
+ * Table of all the locations known by the planner.
+ * Each location gets an id (its position in the table) which never changes, even if the location is removed.
+ * For each status a bucket keeps the ids of the locations having that status, so that lookups by name,
+ * status transitions and the listing of the locations by status do not need any linear search.
+ */
+class LocationTable
+{
+private:
+    vector<LocationEntry>           m_entries;
+    unordered_map<string, size_t>   m_index;
+    vector<size_t>                  m_buckets[LOC_STATUS_COUNT];
+
+    void detach(size_t id);
+    void attach(size_t id, LocationStatus status);
+
+public:
+    static const size_t npos;
+
+    LocationTable() = default;
+    ~LocationTable() = default;
+
+    size_t                  add(const string& name, const Map2DLocation& pose, bool pose_valid, const string& area, LocationStatus status = LOC_UNCHECKED);
+    size_t                  id(const string& name) const;
+    bool                    contains(const string& name) const;
+    size_t                  size() const;
+    void                    clear();
+
+    LocationEntry&          at(size_t id);
+    const LocationEntry&    at(size_t id) const;
+
+    void                    setStatus(size_t id, LocationStatus status);
+    void                    setAllStatus(LocationStatus status);
+    const vector<size_t>&   bucket(LocationStatus status) const;
+    void                    reorderBucket(LocationStatus status, const vector<size_t>& ordered_ids);
+
+    static bool             parseStatus(const string& str, LocationStatus& status);
+    static bool             parseStatusName(const string& str, LocationStatus& status);
+    static string           statusName(LocationStatus status);
+    static string           statusLabel(LocationStatus status);
+};
+
+#endif
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <math.h>
+#include <limits>
+#include "mapGraph.h"
+
+/****************************************************************/
+double MapGraph::distance(const Map2DLocation& a, const Map2DLocation& b)
+{
+    return sqrt(pow(a.x - b.x, 2) + pow(a.y - b.y, 2));
+}
+
+/****************************************************************/
+void MapGraph::addTransition(const string& name, const Map2DLocation& from, const Map2DLocation& to, double cost)
+{
+    MapTransition transition;
+    transition.name = name;
+    transition.cost = cost;
+    m_transitions.push_back(transition);
+
+    MapPortal portal;
+    portal.transition = m_transitions.size() - 1;
+    portal.pose = from;
+    m_portals.push_back(portal);
+    portal.pose = to;
+    m_portals.push_back(portal);
+
+    build();
+}
+
+/****************************************************************/
+void MapGraph::clear()
+{
+    m_transitions.clear();
+    m_portals.clear();
+    m_between.clear();
+    m_next.clear();
+    m_reach.clear();
+    m_robot_map = "";
+}
+
+/****************************************************************/
+bool MapGraph::empty() const
+{
+    return m_transitions.empty();
+}
+
+/****************************************************************/
+void MapGraph::build()
+{
+    //all-pairs shortest paths (Floyd-Warshall) between the portals: there are only a few of them
+    size_t n = m_portals.size();
+    const double inf = numeric_limits<double>::infinity();
+    m_between.assign(n, vector<double>(n, inf));
+    m_next.assign(n, vector<int>(n, -1));
+    for (size_t i = 0; i < n; i++)
+    {
+        for (size_t j = 0; j < n; j++)
+        {
+            double c = inf;
+            if (i == j)
+                c = 0.0;
+            else if (m_portals[i].pose.map_id == m_portals[j].pose.map_id)
+                c = distance(m_portals[i].pose, m_portals[j].pose);
+            if (m_portals[i].transition == m_portals[j].transition && i != j)
+                c = min(c, m_transitions[m_portals[i].transition].cost);
+            m_between[i][j] = c;
+            if (!std::isinf(c))
+                m_next[i][j] = (int)j;
+        }
+    }
+
+    for (size_t k = 0; k < n; k++)
+        for (size_t i = 0; i < n; i++)
+            for (size_t j = 0; j < n; j++)
+            {
+                if (m_between[i][k] + m_between[k][j] < m_between[i][j])
+                {
+                    m_between[i][j] = m_between[i][k] + m_between[k][j];
+                    m_next[i][j] = m_next[i][k];
+                }
+            }
+}
+
+/****************************************************************/
+void MapGraph::reach(const Map2DLocation& from, const function<double(const Map2DLocation&)>& first_leg, vector<double>& reach) const
+{
+    reach.assign(m_portals.size(), numeric_limits<double>::infinity());
+    for (size_t i = 0; i < m_portals.size(); i++)
+    {
+        if (m_portals[i].pose.map_id != from.map_id)
+            continue;
+        double c = first_leg(m_portals[i].pose);
+        for (size_t j = 0; j < m_portals.size(); j++)
+            reach[j] = min(reach[j], c + m_between[i][j]);
+    }
+}
+
+/****************************************************************/
+void MapGraph::update(const Map2DLocation& robotLoc, const function<double(const Map2DLocation&)>& first_leg)
+{
+    m_robot_map = robotLoc.map_id;
+    reach(robotLoc, first_leg, m_reach);
+}
+
+/****************************************************************/
+double MapGraph::cost(const Map2DLocation& loc) const
+{
+    //cost of reaching a location of another map from the robot, as of the last update()
+    double best = numeric_limits<double>::infinity();
+    for (size_t j = 0; j < m_portals.size() && j < m_reach.size(); j++)
+    {
+        if (m_portals[j].pose.map_id == loc.map_id)
+            best = min(best, m_reach[j] + distance(m_portals[j].pose, loc));
+    }
+    return best;
+}
+
+/****************************************************************/
+double MapGraph::between(const Map2DLocation& from, const Map2DLocation& to) const
+{
+    if (from.map_id == to.map_id)
+        return distance(from, to);
+
+    vector<double> fromReach;
+    reach(from, [&from](const Map2DLocation& portal){ return distance(from, portal); }, fromReach);
+    double best = numeric_limits<double>::infinity();
+    for (size_t j = 0; j < m_portals.size(); j++)
+    {
+        if (m_portals[j].pose.map_id == to.map_id)
+            best = min(best, fromReach[j] + distance(m_portals[j].pose, to));
+    }
+    return best;
+}
+
+/****************************************************************/
+bool MapGraph::route(const Map2DLocation& from, const Map2DLocation& to, vector<string>& transitions) const
+{
+    //transitions to take, in order, to go from a map to another
+    transitions.clear();
+    if (from.map_id == to.map_id)
+        return true;
+
+    int bestI {-1}, bestJ {-1};
+    double best = numeric_limits<double>::infinity();
+    for (size_t i = 0; i < m_portals.size(); i++)
+    {
+        if (m_portals[i].pose.map_id != from.map_id)
+            continue;
+        for (size_t j = 0; j < m_portals.size(); j++)
+        {
+            if (m_portals[j].pose.map_id != to.map_id)
+                continue;
+            double c = distance(from, m_portals[i].pose) + m_between[i][j] + distance(m_portals[j].pose, to);
+            if (c < best)
+            {
+                best = c;
+                bestI = (int)i;
+                bestJ = (int)j;
+            }
+        }
+    }
+    if (bestI < 0)
+        return false;
+
+    for (int k = bestI; k != bestJ; )
+    {
+        int next = m_next[k][bestJ];
+        if (m_portals[k].transition == m_portals[next].transition)
+            transitions.push_back(m_transitions[m_portals[k].transition].name);
+        k = next;
+    }
+    return true;
+}
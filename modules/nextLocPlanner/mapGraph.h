@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAP_GRAPH_H
+#define MAP_GRAPH_H
+
+#include <yarp/dev/INavigation2D.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+using namespace yarp::dev::Nav2D;
+using namespace std;
+
+struct MapPortal
+{
+    Map2DLocation   pose;           //where the transition is taken, on the map of this end
+    size_t          transition;     //index of the transition it belongs to
+};
+
+struct MapTransition
+{
+    string          name;           //e.g. "elevator1"
+    double          cost;           //cost of going from one end to the other (waiting for the elevator, opening a door ...)
+};
+
+/**
+ * Connections between the maps of a building (elevators, doors between floor maps).
+ * Each transition links a location of a map to a location of another map with a cost. The shortest paths between
+ * all the transition ends are computed once, moving between the ends of the same map on a straight line.
+ * The cost of reaching a location of another map is then the cost of reaching a transition end on the map of the robot,
+ * plus the shortest path to a transition end on the map of the location, plus the straight-line distance from there.
+ */
+class MapGraph
+{
+private:
+    vector<MapTransition>   m_transitions;
+    vector<MapPortal>       m_portals;      //two for each transition
+    vector<vector<double>>  m_between;      //shortest path cost between two portals
+    vector<vector<int>>     m_next;         //next portal along the shortest path
+    vector<double>          m_reach;        //cost of reaching each portal from the robot, after update()
+    string                  m_robot_map;
+
+    static double   distance(const Map2DLocation& a, const Map2DLocation& b);
+    void            build();
+    void            reach(const Map2DLocation& from, const function<double(const Map2DLocation&)>& first_leg, vector<double>& reach) const;
+
+public:
+    MapGraph() = default;
+    ~MapGraph() = default;
+
+    void    addTransition(const string& name, const Map2DLocation& from, const Map2DLocation& to, double cost);
+    void    clear();
+    bool    empty() const;
+
+    void    update(const Map2DLocation& robotLoc, const function<double(const Map2DLocation&)>& first_leg);
+    double  cost(const Map2DLocation& loc) const;
+    double  between(const Map2DLocation& from, const Map2DLocation& to) const;
+    bool    route(const Map2DLocation& from, const Map2DLocation& to, vector<string>& transitions) const;
+};
+
+#endif
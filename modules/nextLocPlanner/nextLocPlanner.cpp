@@ -17,13 +17,46 @@
  */
 
 #include <math.h>
+#include <limits>
+#include <array>
 #include "nextLocPlanner.h"
 
 YARP_LOG_COMPONENT(NEXT_LOC_PLANNER, "r1_obr.nextLocPlanner")
 
+#define UNREACHABLE_COST 1.0e6
+#define MIN_PRIORS_COST  0.5     //travel costs below this value are not considered when weighting the object priors
+#define FRONTIER_PREFIX  "frontier_"
+#define EXPLORATION_WAIT 5.0     //seconds next waits for the frontiers to be extracted when there are no locations left
+
 NextLocPlanner::NextLocPlanner() :
     m_period(1.0),
-    m_area("")
+    m_area(""),
+    m_use_travel_distance(true),
+    m_use_tour_planner(true),
+    m_tour_max_locations(300),
+    m_search_object(""),
+    m_persist_state(true),
+    m_snapshot_period(30.0),
+    m_last_snapshot_time(0.0),
+    m_ranking_stale(true),
+    m_ranked_pose_valid(false),
+    m_resort_distance(0.5),
+    m_resort_angle(30.0),
+    m_lease_radius(3.0),
+    m_lease_penalty(10.0),
+    m_blocked_backoff(30.0),
+    m_blocked_backoff_max(600.0),
+    m_area_switch_cost(0.0),
+    m_multi_map(false),
+    m_exploration(false),
+    m_frontier_min_distance(1.0),
+    m_frontier_count(0),
+    m_frontiers_checked(0),
+    m_stop_ranking(false),
+    m_ranking_busy(false),
+    m_tour_reset_pending(false),
+    m_ranking_wait(0.5),
+    m_view_dirty(true)
 {  
 }
 
@@ -32,6 +65,71 @@ bool NextLocPlanner::configure(ResourceFinder &rf)
 {   
     m_period = rf.check("period")  ? rf.find("period").asFloat32() : 1.0;
     m_area   = rf.check("area")    ? rf.find("area").asString()    : "";
+    m_use_travel_distance = rf.check("use_travel_distance") ? !(rf.find("use_travel_distance").asString() == "false") : true;
+    if (rf.check("travel_recompute_cells")) {m_travel_cost.setRecomputeThreshold(rf.find("travel_recompute_cells").asInt32());}
+    m_use_tour_planner = rf.check("use_tour_planner") ? !(rf.find("use_tour_planner").asString() == "false") : true;
+    if (rf.check("tour_max_locations")) {m_tour_max_locations = rf.find("tour_max_locations").asInt32();}
+    if (rf.check("tour_improve_passes")) {m_tour_planner.setMaxPasses(rf.find("tour_improve_passes").asInt32());}
+
+    //Object priors
+    string priorsFile = rf.check("priors_file") ? rf.find("priors_file").asString() : "object_priors.txt";
+    if (priorsFile.empty() || priorsFile[0] != '/')
+    {
+        //relative paths are stored in the context of the module, or in the working directory if there is no home context
+        string context = rf.getHomeContextPath();
+        if (context != "")
+            priorsFile = context + "/" + priorsFile;
+        else
+            yCWarning(NEXT_LOC_PLANNER, "No home context path available: the object priors are stored in the working directory");
+    }
+    yCInfo(NEXT_LOC_PLANNER, "Object priors file: %s", priorsFile.c_str());
+    if (rf.check("priors_smoothing")) {m_priors.setSmoothing(rf.find("priors_smoothing").asFloat32());}
+    m_priors.load(priorsFile);
+
+    //Planner state persistence
+    m_persist_state = rf.check("persist_state") ? !(rf.find("persist_state").asString() == "false") : true;
+    string stateDir = rf.check("state_dir") ? rf.find("state_dir").asString() : rf.getHomeContextPath();
+    double stateMaxAge = rf.check("state_max_age") ? rf.find("state_max_age").asFloat32() : 3600.0;
+    if (rf.check("snapshot_period")) {m_snapshot_period = rf.find("snapshot_period").asFloat32();}
+
+    //Ranking updates
+    if (rf.check("resort_distance")) {m_resort_distance = rf.find("resort_distance").asFloat32();}
+    if (rf.check("resort_angle")) {m_resort_angle = rf.find("resort_angle").asFloat32();}
+    if (rf.check("ranking_wait")) {m_ranking_wait = rf.find("ranking_wait").asFloat32();}
+
+    //Reservations of the clients sharing the planner
+    if (rf.check("lease_ttl")) {m_leases.setTtl(rf.find("lease_ttl").asFloat32());}
+    if (rf.check("lease_radius")) {m_lease_radius = rf.find("lease_radius").asFloat32();}
+    if (rf.check("lease_penalty")) {m_lease_penalty = rf.find("lease_penalty").asFloat32();}
+    if (rf.check("blocked_backoff")) {m_blocked_backoff = rf.find("blocked_backoff").asFloat32();}
+    if (rf.check("blocked_backoff_max")) {m_blocked_backoff_max = rf.find("blocked_backoff_max").asFloat32();}
+
+    //Areas hierarchy: from the prefixes of the location names and from the AREAS group, listing '<area/path> (<location1> <location2> ...)'
+    if (rf.check("area_separator")) {m_areas.setSeparator(rf.find("area_separator").asString());}
+    m_areas.useNamePrefixes(rf.check("area_from_names") ? !(rf.find("area_from_names").asString() == "false") : true);
+    if (rf.check("area_switch_cost")) {m_area_switch_cost = rf.find("area_switch_cost").asFloat32();}
+    if (rf.check("spatial_cell_size")) {m_spatial.setCellSize(rf.find("spatial_cell_size").asFloat32());}
+    m_multi_map = rf.check("multi_map") ? rf.find("multi_map").asString() == "true" : false;
+    m_exploration = rf.check("exploration") ? rf.find("exploration").asString() == "true" : false;
+    if (rf.check("frontier_min_size")) {m_explorer.setMinSize(rf.find("frontier_min_size").asInt32());}
+    if (rf.check("frontier_gain_radius")) {m_explorer.setGainRadius(rf.find("frontier_gain_radius").asFloat32());}
+    if (rf.check("frontier_min_distance")) {m_frontier_min_distance = rf.find("frontier_min_distance").asFloat32();}
+    if (rf.check("AREAS"))
+    {
+        Bottle& areas_config = rf.findGroup("AREAS");
+        for (size_t i = 1; i < areas_config.size(); i++)
+        {
+            Bottle* area = areas_config.get(i).asList();
+            if (!area || area->size() < 2 || !area->get(1).isList())
+            {
+                yCWarning(NEXT_LOC_PLANNER,"Wrong entry in AREAS group. Expected '<area/path> (<location1> <location2> ...)'");
+                continue;
+            }
+            Bottle* locs = area->get(1).asList();
+            for (size_t j = 0; j < locs->size(); j++)
+                m_areas.assign(locs->get(j).asString(), area->get(0).asString());
+        }
+    }
 
     //Open RPC Server Port
     string rpcPortName = rf.check("rpcPort") ? rf.find("rpcPort").asString() : "/nextLocPlanner/request/rpc";
@@ -46,6 +144,92 @@ bool NextLocPlanner::configure(ResourceFinder &rf)
         return false;
     }
 
+    //Navigation client, unless the navigation interface has already been given with setNavigation()
+    if (!m_iNav2D && !openNavigationClient(rf))
+        return false;
+
+    //Robot pose streamed by the localization server
+    string localizationPortName = rf.check("localization_port") ? rf.find("localization_port").asString() : "/localization2D_nws_yarp/streaming:o";
+    string localizationLocalPortName = rf.check("localization_port_local") ? rf.find("localization_port_local").asString() : "/nextLocPlanner/localization:i";
+    if (!m_localization_port.open(localizationLocalPortName))
+    {
+        yCWarning(NEXT_LOC_PLANNER, "Cannot open port %s. The robot position will be requested to the navigation server", localizationLocalPortName.c_str());
+    }
+    else
+    {
+        m_localization_port.useCallback(m_pose_listener);
+        if (!Network::connect(localizationPortName, localizationLocalPortName))
+            yCWarning(NEXT_LOC_PLANNER, "Cannot connect to %s. The robot position will be requested to the navigation server", localizationPortName.c_str());
+    }
+
+    MapGrid2D  map;
+    if(!m_iNav2D->getCurrentNavigationMap(NavigationMapTypeEnum::global_map, map))
+    {
+        yCError(NEXT_LOC_PLANNER, "Error retrieving current global map");
+    }
+    else if (m_use_travel_distance && !m_travel_cost.setMap(map))
+    {
+        yCWarning(NEXT_LOC_PLANNER, "The global map is not valid: using straight-line distances to sort the locations");
+    }
+    m_map_name = map.getMapName();
+    m_state_key = m_multi_map ? "all_maps" : m_map_name;
+    m_tour_planner.setUnreachableCost(UNREACHABLE_COST);
+    m_tour_planner.setCostMap(m_use_travel_distance && m_travel_cost.isValid() ? &m_travel_cost : nullptr);
+    if (m_multi_map)
+    {
+        loadMapTransitions(rf);
+        m_tour_planner.setMapGraph(&m_map_graph);
+    }
+
+    //Restore the state saved before a restart, if any, otherwise load the locations from the map server
+    bool restored {false};
+    if (m_persist_state && m_state.open(stateDir))
+    {
+        restored = m_state.load(m_state_key, stateMaxAge, m_locations);
+        for (size_t id = 0; restored && id < m_locations.size(); id++)
+        {
+            if (m_locations.at(id).area != m_area)
+            {
+                yCInfo(NEXT_LOC_PLANNER, "The saved planner state refers to another area. Ignoring it");
+                m_locations.clear();
+                restored = false;
+            }
+        }
+    }
+
+    if (!restored)
+    {
+        if (!loadLocations())
+            return false;
+
+        if (m_persist_state)
+            m_state.writeSnapshot(m_state_key, m_locations);
+    }
+    m_last_snapshot_time = Time::now();
+
+    for (size_t id = 0; id < m_locations.size(); id++)
+    {
+        m_areas.addLocation(id, m_locations.at(id).name);
+        indexLocation(id);
+    }
+    if (m_exploration)
+        restoreFrontiers();
+
+    //locations blocked before a restart: their backoff starts again
+    for (size_t id : m_locations.bucket(LOC_BLOCKED))
+        m_blocked[id] = BlockedLocation{1, Time::now() + m_blocked_backoff};
+
+    //from now on the locations are ranked by the worker, the requests read the published view
+    publishView();
+    m_ranking_worker = thread(&NextLocPlanner::rankingLoop, this);
+    
+    return true;
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::openNavigationClient(ResourceFinder &rf)
+{
     //Navigation2DClient config 
     Property nav2DProp;
         //Defaults
@@ -79,14 +263,21 @@ bool NextLocPlanner::configure(ResourceFinder &rf)
         return false;
     }
 
-    MapGrid2D  map;
-    if(!m_iNav2D->getCurrentNavigationMap(NavigationMapTypeEnum::global_map, map))
-    {
-        yCError(NEXT_LOC_PLANNER, "Error retrieving current global map");
-    }
-    m_map_name = map.getMapName();
+    return true;
+}
+
+
+/****************************************************************/
+void NextLocPlanner::setNavigation(INavigation2D* iNav2D)
+{
+    m_iNav2D = iNav2D;
+}
 
-    //Load all the locations in m_all_locations
+
+/****************************************************************/
+bool NextLocPlanner::loadLocations()
+{
+    //Load all the locations of the current map in the locations table
     vector<string> all_locations;
     if (!m_iNav2D->getLocationsList(all_locations)) 
     {
@@ -97,34 +288,36 @@ bool NextLocPlanner::configure(ResourceFinder &rf)
 
     if(!all_locations.empty()) 
     {
+        bool mapLocationsFound {false};
         for (string & loc_name : all_locations)
         {
             Map2DLocation loc;
-            m_iNav2D->getLocation(loc_name, loc);
-            if(loc.map_id == m_map_name)
-                m_all_locations.push_back(loc_name);
+            if (!m_iNav2D->getLocation(loc_name, loc))
+            {
+                yCWarning(NEXT_LOC_PLANNER,"Cannot retrieve the coordinates of location %s from map server. Skipping it", loc_name.c_str());
+                continue;
+            }
+            if(!m_multi_map && loc.map_id != m_map_name)
+                continue;
+            mapLocationsFound = true;
+
+            //skip locations not belonging to the area defined in .ini file (i.e. whose name contains the name of the area)
+            if (m_area != "" && loc_name.find(m_area) == string::npos)
+                continue;
+
+            m_locations.add(loc_name, loc, true, m_area);
         }
-        if(m_all_locations.empty()) 
+        if(!mapLocationsFound) 
         {
             yCWarning(NEXT_LOC_PLANNER,"Error: no locations from map server for the area specified");
-            return false;
+            return m_exploration;   //exploring, the frontiers of the map are used as locations
         }
         
-        if (m_area != "")
+        if(m_locations.size() == 0) 
         {
-            //remove elements not belonging to the area defined in .ini file (i.e. whose name starts with the name of the area)
-            auto new_end = remove_if(m_all_locations.begin(), m_all_locations.end(), [this](string& str){return (str.find(m_area) == string::npos);} );
-            m_all_locations.erase(new_end, m_all_locations.end());
-
-            if(m_all_locations.empty()) 
-            {
-                yCWarning(NEXT_LOC_PLANNER,"Warning: no locations from map server for the area specified");
-                return false;
-            }
+            yCWarning(NEXT_LOC_PLANNER,"Warning: no locations from map server for the area specified");
+            return m_exploration;
         }
-        
-        m_locations_unchecked.insert(m_locations_unchecked.end(), m_all_locations.begin(), m_all_locations.end());
-
     }
     else
     {
@@ -134,13 +327,64 @@ bool NextLocPlanner::configure(ResourceFinder &rf)
     return true;
 }
 
+/****************************************************************/
+void NextLocPlanner::loadMapTransitions(ResourceFinder &rf)
+{
+    //MAP_TRANSITIONS group, listing '<transition> (<location on a map> <location on another map> <cost>)'
+    if (!rf.check("MAP_TRANSITIONS"))
+    {
+        yCWarning(NEXT_LOC_PLANNER,"MAP_TRANSITIONS section missing in ini file. The locations of the other maps will be considered unreachable");
+        return;
+    }
+
+    Bottle& transitions_config = rf.findGroup("MAP_TRANSITIONS");
+    for (size_t i = 1; i < transitions_config.size(); i++)
+    {
+        Bottle* transition = transitions_config.get(i).asList();
+        Bottle* ends = transition && transition->size() == 2 ? transition->get(1).asList() : nullptr;
+        if (!ends || ends->size() != 3)
+        {
+            yCWarning(NEXT_LOC_PLANNER,"Wrong entry in MAP_TRANSITIONS group. Expected '<transition> (<location1> <location2> <cost>)'");
+            continue;
+        }
+
+        string name = transition->get(0).asString();
+        Map2DLocation from, to;
+        if (!m_iNav2D->getLocation(ends->get(0).asString(), from) || !m_iNav2D->getLocation(ends->get(1).asString(), to))
+        {
+            yCWarning(NEXT_LOC_PLANNER,"Cannot retrieve the ends of transition %s from map server", name.c_str());
+            continue;
+        }
+        m_map_graph.addTransition(name, from, to, ends->get(2).asFloat64());
+        yCInfo(NEXT_LOC_PLANNER,"Transition %s between maps %s and %s", name.c_str(), from.map_id.c_str(), to.map_id.c_str());
+    }
+}
+
+
 /****************************************************************/
 bool NextLocPlanner::close()
 {
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stop_ranking = true;
+    }
+    m_ranking_cv.notify_all();
+    m_ranked_cv.notify_all();
+    if (m_ranking_worker.joinable())
+        m_ranking_worker.join();
 
     if (m_rpc_server_port.asPort().isOpen())
         m_rpc_server_port.close();
 
+    if (!m_localization_port.isClosed())
+        m_localization_port.close();
+
+    if (m_persist_state)
+    {
+        m_state.writeSnapshot(m_state_key, m_locations);
+        m_state.close();
+    }
+
     if(m_nav2DPoly.isValid())
         m_nav2DPoly.close();
        
@@ -157,59 +401,43 @@ double NextLocPlanner::getPeriod()
 /****************************************************************/
 bool NextLocPlanner::setLocationStatus(const string location_name, const string& location_status)
 {
-    bool uncheckedOk = (location_status == "unchecked" || location_status == "Unchecked" || location_status == "UNCHECKED" );
-    bool checkingOk  = (location_status == "checking" || location_status == "Checking"  || location_status == "CHECKING"   );
-    bool checkedOk   = (location_status == "checked"  || location_status == "Checked"   || location_status == "CHECKED"    );
-    if ( !(uncheckedOk || checkedOk || checkingOk)  ) 
+    LocationStatus status;
+    if (!LocationTable::parseStatus(location_status, status)) 
     { 
-        yCError(NEXT_LOC_PLANNER,"Error: wrong location status specified. You should use: unchecked, checking or checked.");
+        yCError(NEXT_LOC_PLANNER,"Error: wrong location status specified. You should use: unchecked, checking, checked or blocked.");
         return false;
     }
 
-    vector<string>::iterator findUnchecked {find(m_locations_unchecked.begin(), m_locations_unchecked.end(), location_name)};
-    vector<string>::iterator findChecking {find(m_locations_checking.begin(), m_locations_checking.end(), location_name)};
-    vector<string>::iterator findChecked {find(m_locations_checked.begin(), m_locations_checked.end(), location_name)};
-    bool locFound { findUnchecked != m_locations_unchecked.end() || findChecking != m_locations_checking.end() || findChecked != m_locations_checked.end()};
-
-    if (locFound) 
+    size_t id = m_locations.id(location_name);
+    if (id != LocationTable::npos && m_locations.at(id).status != LOC_REMOVED) 
     {
-        if (findUnchecked != m_locations_unchecked.end())   { m_locations_unchecked.erase(findUnchecked);}
-        else if(findChecking != m_locations_checking.end()) { m_locations_checking.erase(findChecking);  }
-        else if(findChecked != m_locations_checked.end())   { m_locations_checked.erase(findChecked);    }
-
-
-        if (uncheckedOk)  
-            {m_locations_unchecked.push_back(location_name); }
-        else if (checkingOk)  
-            {m_locations_checking.push_back(location_name); }
-        else if (checkedOk)  
-            {m_locations_checked.push_back(location_name); }
+        m_locations.setStatus(id, status);
+        if (status != LOC_CHECKING)
+            m_leases.releaseLocation(id);   //the client holding the location is done with it
+        if (status == LOC_BLOCKED)
+            blockLocation(id);
+        else if (status == LOC_CHECKED)
+            m_blocked.erase(id);            //reached at last: the next failure starts from the shortest backoff
+        if (m_persist_state)
+            m_state.logStatus(location_name, status);
     }
-    else if (location_name=="all")
+    else if (location_name=="all" && status != LOC_BLOCKED)
     {
-        
-        if (uncheckedOk)   
-        {
-            m_locations_unchecked.insert(m_locations_unchecked.end(), m_locations_checked.begin(), m_locations_checked.end());
-            m_locations_unchecked.insert(m_locations_unchecked.end(), m_locations_checking.begin(), m_locations_checking.end());
-            m_locations_checking.clear();
-            m_locations_checked.clear();
-        }
-        else if (checkingOk)    
-        {
-            m_locations_checking.insert(m_locations_checking.end(), m_locations_checked.begin(), m_locations_checked.end());
-            m_locations_checking.insert(m_locations_checking.end(), m_locations_unchecked.begin(), m_locations_unchecked.end());
-            m_locations_unchecked.clear();
-            m_locations_checked.clear();
-        }
-        else if (checkedOk)    
+        m_locations.setAllStatus(status);
+        m_leases.clear();
+        if (m_persist_state)
+            m_state.logAllStatus(status);
+
+        //a new search does not go back to the locations just found unreachable
+        double now = Time::now();
+        for (const auto& blocked : m_blocked)
         {
-            m_locations_checked.insert(m_locations_checked.end(), m_locations_checking.begin(), m_locations_checking.end());
-            m_locations_checked.insert(m_locations_checked.end(), m_locations_unchecked.begin(), m_locations_unchecked.end());
-            m_locations_unchecked.clear();
-            m_locations_checking.clear();
+            if (blocked.second.until <= now || status == LOC_CHECKED)
+                continue;
+            m_locations.setStatus(blocked.first, LOC_BLOCKED);
+            if (m_persist_state)
+                m_state.logStatus(m_locations.at(blocked.first).name, LOC_BLOCKED);
         }
-
     }
     else
     {
@@ -217,336 +445,1513 @@ bool NextLocPlanner::setLocationStatus(const string location_name, const string&
         return false;
     }
 
-    sortUncheckedLocations();
+    invalidateRanking();
     
     return true;
 }
 
 
 /****************************************************************/
-bool NextLocPlanner::respond(const Bottle &cmd, Bottle &reply)
+bool NextLocPlanner::respondFromView(const Bottle &cmd, Bottle &reply)
 {
-    lock_guard<mutex>  lock(m_mutex);
-    reply.clear();
     string cmd_0=cmd.get(0).asString();
-    if (cmd.size()==1)
+    if (cmd_0=="next_k")   //expected 'next_k <k>' or 'next_k <k> <object>'
     {
-        if (cmd_0=="next")
-        {      
-            if (m_locations_checking.size()>0)
-            {
-                vector<string>::iterator it;
-                for(it = m_locations_checking.begin(); it != m_locations_checking.end(); it++)
-                {
-                    //setting all the "checking" locations as "unchecked"
-                    setLocationStatus(*it, "checking");
-                }
-            }
-
-            if (m_locations_unchecked.size()>0)
-            {                
-                //reading the first unchecked location
-                reply.addString(m_locations_unchecked[0]); 
-                //setting that location as "checking"
-                setLocationStatus(m_locations_unchecked[0], "checking");
-            }
-            else
-            {
-                reply.addString("noLocation");
-            }      
-        }
-        else if (cmd_0=="help")
+        if (cmd.size() < 2 || cmd.size() > 3 || cmd.get(1).asInt32() <= 0)
         {
-            reply.addVocab32("many");
-            reply.addString("next : returns the next unchecked location or noLocation");
-            reply.addString("set <locationName> <status> : sets the status of a location to unchecked, checking or checked");
-            reply.addString("set all <status> : sets the status of all locations");
-            reply.addString("find <locationName> : checks if a location is in the list of the available ones");
-            reply.addString("remove <locationName> : removes the defined location by any list");
-            reply.addString("add <locationName> : adds a previously defined location in the unchecked list");
-            reply.addString("add <locationName> <x,y,th coordinates>: adds a new location in the unchecked list");
-            reply.addString("list : lists all the locations and their status");
-            reply.addString("list2 : lists all the locations divided by their status");
-            reply.addString("close : closes the nextLocationPlanner module");
-            reply.addString("help : gets this list");
+            reply.addVocab32(Vocab32::encode("nack"));
+            yCWarning(NEXT_LOC_PLANNER,"Error: wrong RPC command. Type 'help'");
+            return true;
         }
-        else if (cmd_0=="close")
+        //without an object the ranking of the current search is returned as it is: its object is not changed
+        if (cmd.size() == 3)
+            prepareRanking(cmd.get(2).asString());
+        else
         {
-            close();
+            unique_lock<mutex> lock(m_mutex);
+            waitForRanking(lock, m_ranking_wait);
         }
-        else if (cmd_0=="list")
-        {
-            reply.addVocab32("many");
+    }
+    else if (cmd_0=="plan" && cmd.size()==1)
+    {
+        unique_lock<mutex> lock(m_mutex);
+        waitForRanking(lock, m_ranking_wait);
+    }
+    else if (!(cmd_0=="find" && cmd.size()==2) && cmd_0!="find_many" && !((cmd_0=="list" || cmd_0=="list2") && cmd.size()==1))
+        return false;
 
-            if (m_all_locations.size()!=0)
-            {
-                Bottle& tempList1 = reply.addList();
-                vector<string>::iterator it;
-                for(it = m_all_locations.begin(); it != m_all_locations.end(); it++)
-                {
-                    Bottle& tempList = tempList1.addList();
-                    tempList.addString(*it);
-
-                    if (find(m_locations_unchecked.begin(), m_locations_unchecked.end(), *it) != m_locations_unchecked.end()) 
-                        tempList.addString("Unchecked");
-                    else if (find(m_locations_checking.begin(), m_locations_checking.end(), *it) != m_locations_checking.end()) 
-                        tempList.addString("Checking");
-                    else if (find(m_locations_checked.begin(), m_locations_checked.end(), *it) != m_locations_checked.end()) 
-                        tempList.addString("Checked");
-                    else 
-                        tempList.addString("NotValid or Removed");
-                }
-            }
-        }
-        else if (cmd_0=="list2")
+    shared_ptr<const PlannerView> view = atomic_load(&m_view);
+    if (!view)
+    {
+        reply.addVocab32(Vocab32::encode("nack"));
+        return true;
+    }
+    const vector<string>& names = *view->names;
+
+    if (cmd_0=="find")
+    {
+        size_t id = view->find(cmd.get(1).asString());
+        if (id != LocationTable::npos && view->status[id] != LOC_REMOVED)
+            reply.fromString("ok " + LocationTable::statusName(view->status[id]));
+        else 
+            reply.addString("notValid");
+    }
+    else if (cmd_0=="find_many")     //expected 'find_many <location1> <location2> ...'
+    {
+        reply.addVocab32("many");
+        Bottle& results = reply.addList();
+        for (size_t i = 1; i < cmd.size(); i++)
         {
-            reply.addVocab32("many");
-            Bottle& tempList = reply.addList();
-            
-            tempList.addString("Unchecked: ");
-            if (m_locations_unchecked.size()!=0)
+            string loc = cmd.get(i).asString();
+            Bottle& res = results.addList();
+            res.addString(loc);
+            size_t id = view->find(loc);
+            if (id != LocationTable::npos && view->status[id] != LOC_REMOVED)
             {
-                vector<string>::iterator it;
-                for(it = m_locations_unchecked.begin(); it != m_locations_unchecked.end(); it++)
-                {
-                    tempList.addString(*it);
-                }
+                res.addString("ok");
+                res.addString(LocationTable::statusName(view->status[id]));
             }
-            tempList.addString(" ");
-            tempList.addString("Checking: ");
-            if (m_locations_checking.size()!=0)
-            {
-                vector<string>::iterator it;
-                for(it = m_locations_checking.begin(); it != m_locations_checking.end(); it++)
-                {
-                    tempList.addString(*it);
-                }
-            }
-            tempList.addString(" ");
-            tempList.addString("Checked: ");
-            if (m_locations_checked.size()!=0)
-            {
-                vector<string>::iterator it;
-                for(it = m_locations_checked.begin(); it != m_locations_checked.end(); it++)
-                {
-                    tempList.addString(*it);
-                }
-            }
-        }
-        else
-        {
-            reply.addVocab32(Vocab32::encode("nack"));
-            yCWarning(NEXT_LOC_PLANNER,"Error: wrong RPC command. Type 'help'");
+            else 
+                res.addString("notValid");
         }
     }
-    else if (cmd.size()==2)    //expected 'find <location>', 'add <location>' or 'remove <location>'
+    else if (cmd_0=="list")
     {
-        string loc=cmd.get(1).asString();
-        
-        if (cmd_0=="find")
-        {
-            if (find(m_locations_unchecked.begin(), m_locations_unchecked.end(), loc) != m_locations_unchecked.end())
-                reply.fromString("ok unchecked");
-            else if(find(m_locations_checking.begin(), m_locations_checking.end(), loc) != m_locations_checking.end())
-                reply.fromString("ok checking");
-            else if(find(m_locations_checked.begin(), m_locations_checked.end(), loc) != m_locations_checked.end())
-                reply.fromString("ok checked");
-            else 
-                reply.addString("notValid");
+        reply.addVocab32("many");
 
-        }
-        else if (cmd_0=="add")
+        if (names.size()!=0)
         {
-            if(addLocation(loc))
-                reply.addString(loc + " added as unchecked location ");
-            else
+            Bottle& tempList1 = reply.addList();
+            for(size_t id = 0; id < names.size(); id++)
             {
-                reply.addString(loc + " NOT added");
-                yCWarning(NEXT_LOC_PLANNER,"Cannot add %s. It is not listed as a valid location for this map", loc.c_str());
+                Bottle& tempList = tempList1.addList();
+                tempList.addString(names[id]);
+                tempList.addString(LocationTable::statusLabel(view->status[id]));
             }
         }
-        else if (cmd_0=="remove")
+    }
+    else if (cmd_0=="list2")
+    {
+        reply.addVocab32("many");
+        Bottle& tempList = reply.addList();
+        
+        for (int s = LOC_UNCHECKED; s < LOC_REMOVED; s++)
         {
-            if(removeLocation(loc))
-                reply.addString(loc + " removed");
-            else
+            if (s != LOC_UNCHECKED)
+                tempList.addString(" ");
+            tempList.addString(LocationTable::statusLabel((LocationStatus)s) + ": ");
+            for (size_t id : view->buckets[s])
             {
-                reply.addString(loc + " NOT removed");
-                yCWarning(NEXT_LOC_PLANNER,"Cannot remove %s", loc.c_str());
+                tempList.addString(names[id]);
             }
         }
-        else
+    }
+    else if (cmd_0=="next_k")
+    {
+        //the locations are only returned, their status is not changed
+        const vector<size_t>& unchecked = view->buckets[LOC_UNCHECKED];
+        size_t k = min((size_t)cmd.get(1).asInt32(), unchecked.size());
+
+        reply.addVocab32("many");
+        Bottle& results = reply.addList();
+        for (size_t i = 0; i < k; i++)
         {
-            reply.addVocab32(Vocab32::encode("nack"));
-            yCWarning(NEXT_LOC_PLANNER,"Error: wrong RPC command. Type 'help'");
+            //when the order is not a planned tour the direct cost from the robot is returned.
+            //the locations not ranked yet have no cost and are left out
+            size_t id = unchecked[i];
+            double cost = std::isnan(view->cumulative[id]) ? view->robot_cost[id] : view->cumulative[id];
+            if (std::isnan(cost))
+                continue;
+            Bottle& res = results.addList();
+            res.addString(names[id]);
+            res.addFloat64(cost);
         }
     }
-    else if (cmd.size()==3)    //expected 'set <location> <status>'  or 'set all <status>'
+    else if (cmd_0=="plan")
     {
-        if (cmd_0=="set")
+        reply.addVocab32("many");
+        Bottle& tourList = reply.addList();
+        for (size_t id : view->buckets[LOC_UNCHECKED])
         {
-            string cmd_1=cmd.get(1).asString();
-            string cmd_2=cmd.get(2).asString();
-
-            if(!setLocationStatus(cmd_1, cmd_2))
-            {
-                reply.addVocab32(Vocab32::encode("nack"));
-            }
+            double cost = std::isnan(view->cumulative[id]) ? view->robot_cost[id] : view->cumulative[id];
+            if (std::isnan(cost))
+                break;
+            Bottle& tempList = tourList.addList();
+            tempList.addString(names[id]);
+            tempList.addFloat64(cost);
         }
-        else
+        if (!std::isnan(view->total_cost))
         {
-            reply.addVocab32(Vocab32::encode("nack"));
-            yCWarning(NEXT_LOC_PLANNER,"Error: wrong RPC command. Type 'help'");
+            Bottle& costList = reply.addList();
+            costList.addString("total_cost");
+            costList.addFloat64(view->total_cost);
         }
     }
-    else if (cmd.size()==5)    //expected 'add <location> <x> <y> <th>'
+
+    return true;
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::respondBatch(const Bottle &cmd, Bottle &reply)
+{
+    string cmd_0=cmd.get(0).asString();
+    if (cmd_0=="set_many")  //expected 'set_many <status> <location1> <location2> ...' or 'set_many (<location1> <status1>) (<location2> <status2>) ...'
     {
-        
-        string locName = cmd.get(1).asString();
-        double x = cmd.get(2).asFloat32();
-        double y = cmd.get(3).asFloat32();
-        double th = cmd.get(4).asFloat32();
-
-        Map2DLocation loc;
-        loc.map_id=m_map_name;
-        loc.x=x;
-        loc.y=y;
-        loc.theta=th;
-        loc.description=locName;
-
-        if(addLocation(locName, loc))
-            reply.addString(locName + " added");
-        else
+        reply.addVocab32("many");
+        Bottle& results = reply.addList();
+        bool sameStatus = cmd.size() > 1 && !cmd.get(1).isList();
+        string status = sameStatus ? cmd.get(1).asString() : "";
+        for (size_t i = sameStatus ? 2 : 1; i < cmd.size(); i++)
         {
-            reply.addString(locName + " NOT added");
-            yCWarning(NEXT_LOC_PLANNER,"Cannot add %s", locName.c_str());
+            string loc = cmd.get(i).asString();
+            if (!sameStatus)
+            {
+                Bottle* locStatus = cmd.get(i).asList();
+                loc = locStatus && locStatus->size() == 2 ? locStatus->get(0).asString() : "";
+                status = locStatus && locStatus->size() == 2 ? locStatus->get(1).asString() : "";
+            }
+            Bottle& res = results.addList();
+            res.addString(loc);
+            res.addString(setLocationStatus(loc, status) ? "ok" : "nack");
         }
-            
     }
     else
-    {
-        reply.addVocab32(Vocab32::encode("nack"));
-        yCWarning(NEXT_LOC_PLANNER,"Error: input RPC command bottle has a wrong number of elements.");
-    }
-    
-    if (reply.size()==0)
-        reply.addVocab32(Vocab32::encode("ack")); 
+        return false;
 
     return true;
 }
 
 
 /****************************************************************/
-bool NextLocPlanner::getCurrentCheckingLocation(string& location_name)
+bool NextLocPlanner::respondNext(const Bottle &cmd, Bottle &reply)
 {
-    if (m_locations_checking.size()==0)
+    //expected 'next [<object>] [in area:<area>] [client <clientId>] [pose (<x> <y> [<theta> <map>])]', the plain 'next' and 'next <object>' are handled by respond
+    if (cmd.get(0).asString()!="next" || cmd.size() < 3)
+        return false;
+
+    size_t i = 1;
+    string object = "";
+    if (!isNextOption(cmd.get(i).asString()))
+        object = cmd.get(i++).asString();
+
+    string client = "";
+    vector<int> areas;
+    bool areaSpecified {false};
+    Map2DLocation clientPose;
+    bool poseSpecified {false};
+    for ( ; i + 1 < cmd.size(); i += 2)
     {
-        location_name = "<noLocation>";
+        string key = cmd.get(i).asString();
+        if (key == "client")
+            client = cmd.get(i+1).asString();
+        else if (key == "in" && parseArea(cmd.get(i+1).asString(), areas))
+            areaSpecified = true;
+        else if (key == "pose" && parsePose(cmd.get(i+1), clientPose))
+            poseSpecified = true;
+        else
+            break;
     }
-    else if (m_locations_checking.size()==1)
+    if (i != cmd.size())
     {
-        location_name = m_locations_checking[0];
+        reply.addVocab32(Vocab32::encode("nack"));
+        yCWarning(NEXT_LOC_PLANNER,"Error: wrong next command. Expected 'next [<object>] [in area:<area>] [client <clientId>] [pose (<x> <y> [<theta> <map>])]'");
+        return true;
     }
-    else
+
+    if (object != m_search_object)
     {
-        yCWarning(NEXT_LOC_PLANNER,"Warning: more than one location set as Checking");
-        location_name = m_locations_checking.back();
+        m_search_object = object;
+        invalidateRanking();
+    }
+
+    string loc_name;
+    if (getNextLocation(loc_name, areaSpecified ? &areas : nullptr, poseSpecified ? &clientPose : nullptr))
+    {
+        if (client != "")
+            m_leases.reserve(client, m_locations.id(loc_name), Time::now());
+        reply.addString(loc_name);
     }
+    else
+        reply.addString("noLocation");
+
     return true;
 }
 
 
 /****************************************************************/
-bool NextLocPlanner::getUncheckedLocations(vector<string>& location_list)
+void NextLocPlanner::releaseCaller(const Bottle &cmd)
 {
-    if (m_locations_unchecked.size()==0)
+    //the client is moving on: its previous location keeps its status, the others are no longer kept away from it.
+    //released before the ranking is prepared, so that the client is not pushed away from its own reservation
+    for (size_t i = 1; i + 1 < cmd.size(); i++)
     {
-        location_list.push_back("<noLocation>");
-    }
-    else
-    {
-        location_list = m_locations_unchecked;
+        if (cmd.get(i).asString() != "client")
+            continue;
+        lock_guard<mutex> lock(m_mutex);
+        if (m_leases.releaseClient(cmd.get(i+1).asString()))
+            invalidateRanking();
+        return;
     }
-    return true;
 }
 
 
 /****************************************************************/
-bool NextLocPlanner::getCheckedLocations(vector<string>& location_list)
+bool NextLocPlanner::isNextOption(const string& token)
 {
-    if (m_locations_checked.size()==0)
-    {
-        location_list.push_back("<noLocation>");
+    return token == "in" || token == "client" || token == "pose";
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::parsePose(const Value& value, Map2DLocation& pose)
+{
+    //(<x> <y> [<theta> <map>]): without the map, the client is on the map of the planner
+    const Bottle* list = value.asList();
+    if (!list || list->size() < 2 || (!list->get(0).isFloat64() && !list->get(0).isInt32()))
+        return false;
+    pose.x = list->get(0).asFloat64();
+    pose.y = list->get(1).asFloat64();
+    pose.theta = list->size() > 2 ? list->get(2).asFloat64() : 0.0;
+    pose.map_id = list->size() > 3 ? list->get(3).asString() : m_map_name;
+    return true;
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::parseArea(const string& token, vector<int>& areas)
+{
+    const string prefix = "area:";
+    if (token.compare(0, prefix.size(), prefix) != 0)
+        return false;
+
+    if (!m_areas.resolve(token.substr(prefix.size()), areas))
+    {
+        yCWarning(NEXT_LOC_PLANNER,"Area %s not found", token.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::setAreaStatus(const vector<int>& areas, const string& location_status)
+{
+    LocationStatus status;
+    if (!LocationTable::parseStatus(location_status, status)) 
+    { 
+        yCError(NEXT_LOC_PLANNER,"Error: wrong location status specified. You should use: unchecked, checking, checked or blocked.");
+        return false;
+    }
+
+    vector<size_t> ids;
+    m_areas.locations(areas, ids);
+    for (size_t id : ids)
+    {
+        if (m_locations.at(id).status != LOC_REMOVED)
+            setLocationStatus(m_locations.at(id).name, location_status);
+    }
+    return true;
+}
+
+
+/****************************************************************/
+void NextLocPlanner::listAreas(Bottle& reply)
+{
+    //counts and travel costs of each area include the ones of its sub-areas, the costs are the ones of the last ranking
+    shared_ptr<const PlannerView> view = atomic_load(&m_view);
+    size_t n = m_areas.size();
+    vector<array<size_t, LOC_STATUS_COUNT>> counts(n);
+    vector<double> minCost(n, numeric_limits<double>::infinity());
+    for (auto& c : counts)
+        c.fill(0);
+
+    for (size_t id = 0; id < m_locations.size(); id++)
+    {
+        const LocationEntry& entry = m_locations.at(id);
+        for (int area = m_areas.areaOf(id); area >= 0; area = m_areas.at(area).parent)
+        {
+            counts[area][entry.status]++;
+            if (entry.status == LOC_UNCHECKED && id < view->robot_cost.size() && !std::isnan(view->robot_cost[id]))
+                minCost[area] = min(minCost[area], view->robot_cost[id]);
+        }
+    }
+
+    reply.addVocab32("many");
+    Bottle& results = reply.addList();
+    for (size_t area = 1; area < n; area++)
+    {
+        Bottle& res = results.addList();
+        res.addString(m_areas.at(area).path);
+        res.addInt32((int)counts[area][LOC_UNCHECKED]);
+        res.addInt32((int)counts[area][LOC_CHECKING]);
+        res.addInt32((int)counts[area][LOC_CHECKED]);
+        res.addFloat64(std::isinf(minCost[area]) ? -1.0 : minCost[area]);
+    }
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::respondLease(const Bottle &cmd, Bottle &reply)
+{
+    string cmd_0=cmd.get(0).asString();
+    if (cmd_0=="heartbeat" && cmd.size()==2)
+    {
+        if (m_leases.renew(cmd.get(1).asString(), Time::now()))
+            reply.addString("ok");
+        else
+            reply.addString("noLease");
+    }
+    else if (cmd_0=="release" && cmd.size()==2)
+    {
+        if (m_leases.releaseClient(cmd.get(1).asString()))
+        {
+            invalidateRanking();
+            reply.addString("ok");
+        }
+        else
+            reply.addString("noLease");
+    }
+    else if (cmd_0=="leases" && cmd.size()==1)
+    {
+        reply.addVocab32("many");
+        Bottle& results = reply.addList();
+        double now = Time::now();
+        for (const auto& lease : m_leases.leases())
+        {
+            Bottle& res = results.addList();
+            res.addString(lease.first);
+            res.addString(m_locations.at(lease.second.id).name);
+            res.addFloat64(lease.second.expiry - now);
+        }
+    }
+    else
+        return false;
+
+    return true;
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::respondSpatial(const Bottle &cmd, Bottle &reply)
+{
+    string cmd_0=cmd.get(0).asString();
+    vector<pair<double,size_t>> found;
+    if (cmd_0=="nearest" && (cmd.size()==3 || cmd.size()==4))   //expected 'nearest <x> <y> [<k>]'
+    {
+        int k = cmd.size()==4 ? cmd.get(3).asInt32() : 1;
+        if (k <= 0)
+        {
+            reply.addVocab32(Vocab32::encode("nack"));
+            return true;
+        }
+        m_spatial.nearest(cmd.get(1).asFloat64(), cmd.get(2).asFloat64(), (size_t)k, found);
+    }
+    else if (cmd_0=="within" && cmd.size()==4)    //expected 'within <x> <y> <r>'
+    {
+        m_spatial.within(cmd.get(1).asFloat64(), cmd.get(2).asFloat64(), cmd.get(3).asFloat64(), found);
+    }
+    else
+        return false;
+
+    reply.addVocab32("many");
+    Bottle& results = reply.addList();
+    for (const auto& f : found)
+    {
+        const LocationEntry& entry = m_locations.at(f.second);
+        Bottle& res = results.addList();
+        res.addString(entry.name);
+        res.addString(LocationTable::statusName(entry.status));
+        res.addFloat64(f.first);
+    }
+
+    return true;
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::respondRoute(const Bottle &cmd, Bottle &reply)
+{
+    //expected 'route <location>': the map of the location and the transitions to take to get there from the robot map
+    Map2DLocation robotLoc;
+    bool poseOk = getRobotPose(robotLoc);
+
+    lock_guard<mutex>  lock(m_mutex);
+    size_t id = m_locations.id(cmd.get(1).asString());
+    if (id == LocationTable::npos || m_locations.at(id).status == LOC_REMOVED || !m_locations.at(id).pose_valid)
+    {
+        reply.addString("notValid");
+        return true;
+    }
+    if (!poseOk)
+    {
+        reply.addVocab32(Vocab32::encode("nack"));
+        yCWarning(NEXT_LOC_PLANNER,"Cannot retrieve the current robot position");
+        return true;
+    }
+
+    const Map2DLocation& loc = m_locations.at(id).pose;
+    vector<string> transitions;
+    if (!m_map_graph.route(robotLoc, loc, transitions))
+    {
+        reply.addString("noRoute");
+        return true;
+    }
+
+    reply.addVocab32("many");
+    reply.addString(loc.map_id);
+    Bottle& via = reply.addList();
+    for (const string& t : transitions)
+        via.addString(t);
+    return true;
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::respond(const Bottle &cmd, Bottle &reply)
+{
+    reply.clear();
+    string cmd_0=cmd.get(0).asString();
+
+    //read-only requests, answered from the last published view without taking the lock
+    if (respondFromView(cmd, reply))
+        return true;
+
+    if (cmd_0=="route" && cmd.size()==2)
+        return respondRoute(cmd, reply);
+
+    if (cmd_0=="close" && cmd.size()==1)
+    {
+        close();    //takes the lock to stop the ranking worker
+        reply.addVocab32(Vocab32::encode("ack"));
+        return true;
+    }
+
+    //next takes the first location of the last ranking: if it is stale, the worker is given a little time to update it
+    if (cmd_0=="next")
+    {
+        string object = cmd.size() > 1 && !isNextOption(cmd.get(1).asString()) ? cmd.get(1).asString() : "";
+        releaseCaller(cmd);
+        prepareRanking(object);
+    }
+
+    //a new location is stored in the map server before taking the lock, as respondRoute does with the robot pose
+    Map2DLocation newLoc;
+    bool newLocStored {false};
+    if (cmd_0=="add" && cmd.size()==5)
+        newLocStored = storeNewLocation(cmd, newLoc);
+
+    lock_guard<mutex>  lock(m_mutex);
+    if (respondBatch(cmd, reply))
+    {
+        //batched commands, with any number of elements
+    }
+    else if (respondNext(cmd, reply))
+    {
+        //next with options
+    }
+    else if (respondLease(cmd, reply))
+    {
+        //commands of the clients sharing the planner
+    }
+    else if (respondSpatial(cmd, reply))
+    {
+        //queries on the location poses
+    }
+    else if (cmd.size()==1)
+    {
+        if (cmd_0=="next")
+        {      
+            string loc_name;
+            if (m_search_object != "")
+            {
+                m_search_object = "";
+                invalidateRanking();
+            }
+
+            if (getNextLocation(loc_name))
+                reply.addString(loc_name); 
+            else
+                reply.addString("noLocation");
+        }
+        else if (cmd_0=="help")
+        {
+            reply.addVocab32("many");
+            reply.addString("next : returns the next unchecked location or noLocation");
+            reply.addString("next <object> : returns the next unchecked location where to look for <object>, considering where it has been found before");
+            reply.addString("set <locationName> <status> : sets the status of a location to unchecked, checking, checked or blocked");
+            reply.addString("set <locationName> blocked : the location could not be reached: it is skipped for a time that doubles at each failure in a row");
+            reply.addString("blocked : lists the blocked locations with the failures in a row and the seconds left before they are unchecked again");
+            reply.addString("set all <status> : sets the status of all locations");
+            reply.addString("set <locationName> checked <object> : sets the location as checked and records that <object> has been found there");
+            reply.addString("find <locationName> : checks if a location is in the list of the available ones");
+            reply.addString("remove <locationName> : removes the defined location by any list");
+            reply.addString("add <locationName> : adds a previously defined location in the unchecked list");
+            reply.addString("add <locationName> <x,y,th coordinates>: adds a new location in the unchecked list");
+            reply.addString("list : lists all the locations and their status");
+            reply.addString("list2 : lists all the locations divided by their status");
+            reply.addString("find_many <locationName1> <locationName2> ... : checks several locations at once");
+            reply.addString("set_many <status> <locationName1> <locationName2> ... : sets the status of several locations at once");
+            reply.addString("set_many (<locationName1> <status1>) (<locationName2> <status2>) ... : sets the status of several locations at once");
+            reply.addString("next_k <k> [<object>] : returns the next k unchecked locations with the estimated cost to reach them, without changing their status");
+            reply.addString("next [<object>] [in area:<area>] [client <clientId>] [pose (<x> <y> [<theta> <map>])] : as next, only among the locations of <area>, reserving the returned location for <clientId> until it is set checked or the lease expires and choosing it from the client <pose> instead of the planner localization");
+            reply.addString("set area:<area> <status> : sets the status of all the locations of an area and its sub-areas");
+            reply.addString("areas : lists the areas with the number of unchecked, checking and checked locations and the cost to reach the closest unchecked one");
+            reply.addString("heartbeat <clientId> : renews the lease of <clientId> on its location");
+            reply.addString("release <clientId> : drops the lease of <clientId>, leaving its location status as it is");
+            reply.addString("leases : lists the reserved locations with their client and the seconds left before the lease expires");
+            reply.addString("nearest <x> <y> [<k>] : returns the k (default 1) locations closest to (x,y) with their status and distance");
+            reply.addString("within <x> <y> <r> : returns the locations within r meters from (x,y) with their status and distance, closest first");
+            reply.addString("route <locationName> : returns the map of the location and the transitions (elevators, doors) to take to get there from the robot map");
+            reply.addString("plan : returns the planned visiting order of the unchecked locations with the estimated cost to reach each of them");
+            reply.addString("close : closes the nextLocationPlanner module");
+            reply.addString("help : gets this list");
+        }
+        else if (cmd_0=="areas")
+        {
+            listAreas(reply);
+        }
+        else if (cmd_0=="blocked")
+        {
+            listBlocked(reply);
+        }
+        else
+        {
+            reply.addVocab32(Vocab32::encode("nack"));
+            yCWarning(NEXT_LOC_PLANNER,"Error: wrong RPC command. Type 'help'");
+        }
+    }
+    else if (cmd.size()==2)    //expected 'next <object>', 'add <location>' or 'remove <location>'
+    {
+        string loc=cmd.get(1).asString();
+        
+        if (cmd_0=="next")
+        {
+            string loc_name;
+            if (loc != m_search_object)
+            {
+                m_search_object = loc;
+                invalidateRanking();
+            }
+
+            if (getNextLocation(loc_name))
+                reply.addString(loc_name); 
+            else
+                reply.addString("noLocation");
+        }
+        else if (cmd_0=="add")
+        {
+            if(addLocation(loc))
+                reply.addString(loc + " added as unchecked location ");
+            else
+            {
+                reply.addString(loc + " NOT added");
+                yCWarning(NEXT_LOC_PLANNER,"Cannot add %s. It is not listed as a valid location for this map", loc.c_str());
+            }
+        }
+        else if (cmd_0=="remove")
+        {
+            if(removeLocation(loc))
+                reply.addString(loc + " removed");
+            else
+            {
+                reply.addString(loc + " NOT removed");
+                yCWarning(NEXT_LOC_PLANNER,"Cannot remove %s", loc.c_str());
+            }
+        }
+        else
+        {
+            reply.addVocab32(Vocab32::encode("nack"));
+            yCWarning(NEXT_LOC_PLANNER,"Error: wrong RPC command. Type 'help'");
+        }
+    }
+    else if (cmd.size()==3)    //expected 'set <location> <status>'  or 'set all <status>'
+    {
+        if (cmd_0=="set")
+        {
+            string cmd_1=cmd.get(1).asString();
+            string cmd_2=cmd.get(2).asString();
+            vector<int> areas;
+
+            if (cmd_1.compare(0, 5, "area:") == 0)
+            {
+                if (!parseArea(cmd_1, areas) || !setAreaStatus(areas, cmd_2))
+                    reply.addVocab32(Vocab32::encode("nack"));
+            }
+            else if(!setLocationStatus(cmd_1, cmd_2))
+            {
+                reply.addVocab32(Vocab32::encode("nack"));
+            }
+        }
+        else
+        {
+            reply.addVocab32(Vocab32::encode("nack"));
+            yCWarning(NEXT_LOC_PLANNER,"Error: wrong RPC command. Type 'help'");
+        }
+    }
+    else if (cmd.size()==4)    //expected 'set <location> checked <object>'
+    {
+        string cmd_1=cmd.get(1).asString();
+        string cmd_2=cmd.get(2).asString();
+        string cmd_3=cmd.get(3).asString();
+        LocationStatus status;
+
+        if (cmd_0=="set" && cmd_1!="all" && LocationTable::parseStatus(cmd_2, status) && status==LOC_CHECKED)
+        {
+            if(setLocationStatus(cmd_1, cmd_2))
+                recordObjectFound(cmd_1, cmd_3);
+            else
+                reply.addVocab32(Vocab32::encode("nack"));
+        }
+        else
+        {
+            reply.addVocab32(Vocab32::encode("nack"));
+            yCWarning(NEXT_LOC_PLANNER,"Error: wrong RPC command. Type 'help'");
+        }
+    }
+    else if (cmd.size()==5)    //expected 'add <location> <x> <y> <th>'
+    {
+        string locName = cmd.get(1).asString();
+        if(newLocStored && addLocation(locName, newLoc))
+            reply.addString(locName + " added");
+        else
+        {
+            reply.addString(locName + " NOT added");
+            yCWarning(NEXT_LOC_PLANNER,"Cannot add %s", locName.c_str());
+        }
+            
+    }
+    else
+    {
+        reply.addVocab32(Vocab32::encode("nack"));
+        yCWarning(NEXT_LOC_PLANNER,"Error: input RPC command bottle has a wrong number of elements.");
+    }
+    
+    if (reply.size()==0)
+        reply.addVocab32(Vocab32::encode("ack")); 
+
+    if (m_view_dirty)
+        publishView();
+
+    return true;
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::getNextLocation(string& location_name, const vector<int>* areas, const Map2DLocation* from)
+{
+    //the unchecked locations are kept in the order of the last ranking
+    const vector<size_t>& unchecked = m_locations.bucket(LOC_UNCHECKED);
+    auto next = unchecked.begin();
+    if (areas)
+        next = find_if(unchecked.begin(), unchecked.end(), [&](size_t id){ return m_areas.contains(*areas, id); });
+    if (next == unchecked.end())
+        return false;
+    if (from)
+        next = closestToClient(unchecked, areas, *from);
+
+    //reading the first unchecked location
+    location_name = m_locations.at(*next).name;
+    const LocationEntry& entry = m_locations.at(*next);
+    if (m_multi_map && entry.pose_valid && entry.pose.map_id != m_map_name)
+        yCInfo(NEXT_LOC_PLANNER,"%s is on map %s: the robot has to move there from map %s", location_name.c_str(), entry.pose.map_id.c_str(), m_map_name.c_str());
+    //setting that location as "checking"
+    setLocationStatus(location_name, "checking");
+    return true;
+}
+
+
+/****************************************************************/
+void NextLocPlanner::recordObjectFound(const string& location_name, const string& object)
+{
+    m_priors.record(object, location_name);
+    m_priors.save();
+    yCInfo(NEXT_LOC_PLANNER,"%s found at %s: %d times so far", object.c_str(), location_name.c_str(), m_priors.count(object, location_name));
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::getCurrentCheckingLocation(string& location_name)
+{
+    const vector<size_t>& checking = m_locations.bucket(LOC_CHECKING);
+    if (checking.size()==0)
+    {
+        location_name = "<noLocation>";
+    }
+    else if (checking.size()==1)
+    {
+        location_name = m_locations.at(checking[0]).name;
+    }
+    else
+    {
+        yCWarning(NEXT_LOC_PLANNER,"Warning: more than one location set as Checking");
+        location_name = m_locations.at(checking.back()).name;
+    }
+    return true;
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::getUncheckedLocations(vector<string>& location_list)
+{
+    const vector<size_t>& unchecked = m_locations.bucket(LOC_UNCHECKED);
+    if (unchecked.size()==0)
+    {
+        location_list.push_back("<noLocation>");
+    }
+    else
+    {
+        location_list.clear();
+        for (size_t id : unchecked)
+            location_list.push_back(m_locations.at(id).name);
+    }
+    return true;
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::getCheckedLocations(vector<string>& location_list)
+{
+    const vector<size_t>& checked = m_locations.bucket(LOC_CHECKED);
+    if (checked.size()==0)
+    {
+        location_list.push_back("<noLocation>");
     }
     else
     {
-        location_list = m_locations_checked;
+        location_list.clear();
+        for (size_t id : checked)
+            location_list.push_back(m_locations.at(id).name);
     }
     return true;
 }
 
 
 /****************************************************************/
-double NextLocPlanner::distRobotLocation(const string& location_name)
+double NextLocPlanner::distRobotLocation(const LocationTable& table, const Map2DLocation& robotLoc, size_t location_id)
 {
-    Map2DLocation robotLoc;
-    Map2DLocation loc;
-    m_iNav2D->getCurrentPosition(robotLoc);
-    m_iNav2D->getLocation(location_name, loc);
+    const LocationEntry& entry = table.at(location_id);
+    if (!entry.pose_valid)
+        return numeric_limits<double>::max();
+    const Map2DLocation& loc = entry.pose;
 
     return sqrt(pow((robotLoc.x - loc.x), 2) + pow((robotLoc.y - loc.y), 2));
 }
 
 
+/****************************************************************/
+vector<size_t>::const_iterator NextLocPlanner::closestToClient(const vector<size_t>& unchecked, const vector<int>* areas, const Map2DLocation& from)
+{
+    //the shared ranking follows the pose of the planner localization: a client sending its own pose gets the location
+    // best for it, with the same criteria of the ranking but on straight-line distances. The frontiers are still
+    // taken only when no other location is left, ties keep the ranking order
+    bool usePriors = m_search_object != "" && m_priors.hasPriors(m_search_object);
+    auto best = unchecked.end();
+    pair<bool,double> bestScore;
+    for (auto it = unchecked.begin(); it != unchecked.end(); it++)
+    {
+        size_t id = *it;
+        if (areas && !m_areas.contains(*areas, id))
+            continue;
+
+        const LocationEntry& entry = m_locations.at(id);
+        double cost = UNREACHABLE_COST;
+        if (entry.pose_valid && entry.pose.map_id == from.map_id)
+            cost = sqrt(pow(entry.pose.x - from.x, 2) + pow(entry.pose.y - from.y, 2));
+        else if (!entry.pose_valid)
+            cost = 2 * UNREACHABLE_COST;
+        cost += reservationPenalty(id);
+
+        double score = cost;
+        if (usePriors)
+            score = -m_priors.probability(m_search_object, entry.name, m_locations.size()) / max(cost, MIN_PRIORS_COST);
+
+        pair<bool,double> candidate(m_frontier_gain.count(id) > 0, score);
+        if (best == unchecked.end() || candidate < bestScore)
+        {
+            best = it;
+            bestScore = candidate;
+        }
+    }
+    return best;
+}
+
+
+/****************************************************************/
+double NextLocPlanner::reservationPenalty(size_t location_id)
+{
+    //locations close to the ones reserved by other robots are pushed back, so that each robot searches its own region
+    const LocationEntry& entry = m_locations.at(location_id);
+    if (m_leases.empty() || !entry.pose_valid || m_lease_radius <= 0)
+        return 0.0;
+
+    double penalty {0.0};
+    for (const auto& lease : m_leases.leases())
+    {
+        const LocationEntry& reserved = m_locations.at(lease.second.id);
+        if (!reserved.pose_valid || reserved.pose.map_id != entry.pose.map_id)
+            continue;
+
+        double d = sqrt(pow(entry.pose.x - reserved.pose.x, 2) + pow(entry.pose.y - reserved.pose.y, 2));
+        if (d < m_lease_radius)
+            penalty += m_lease_penalty * (1.0 - d / m_lease_radius);
+    }
+    return penalty;
+}
+
+
+/****************************************************************/
+double NextLocPlanner::costRobotLocation(const LocationTable& table, const Map2DLocation& robotLoc, size_t location_id)
+{
+    //one ranking is shared by all the clients: <robotLoc> is the pose from the localization the planner is connected to.
+    // the clients sending their pose with next are served by closestToClient instead
+    const LocationEntry& entry = table.at(location_id);
+    if (m_multi_map && entry.pose_valid && entry.pose.map_id != robotLoc.map_id)
+    {
+        //location on another map: reached through the transitions between the maps
+        double through = m_map_graph.cost(entry.pose);
+        return std::isinf(through) ? UNREACHABLE_COST : through;
+    }
+
+    double dist = distRobotLocation(table, robotLoc, location_id);
+    if (!m_use_travel_distance || !m_travel_cost.isValid() || dist == numeric_limits<double>::max())
+        return dist;
+    if (m_multi_map && robotLoc.map_id != m_travel_cost.getMap().getMapName())
+        return dist;
+
+    double travel = m_travel_cost.cost(table.at(location_id).pose);
+    if (!std::isinf(travel))
+        return travel;
+
+    //location not reachable on the map: keep it after all the reachable ones
+    return UNREACHABLE_COST + dist;
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::storeNewLocation(const Bottle &cmd, Map2DLocation& loc)
+{
+    //expected 'add <location> <x> <y> <th>', on the map the robot is on
+    {
+        lock_guard<mutex> lock(m_mutex);
+        loc.map_id = m_map_name;
+    }
+    loc.x = cmd.get(2).asFloat32();
+    loc.y = cmd.get(3).asFloat32();
+    loc.theta = cmd.get(4).asFloat32();
+    loc.description = cmd.get(1).asString();
+
+    if (!m_iNav2D->storeLocation(cmd.get(1).asString(), loc))
+    {
+        yCWarning(NEXT_LOC_PLANNER,"Cannot store location %s in map server", cmd.get(1).asString().c_str());
+        return false;
+    }
+    return true;
+}
+
+
+/****************************************************************/
+void NextLocPlanner::indexLocation(size_t location_id)
+{
+    //only the locations of the current map which have not been removed can be returned by nearest and within
+    const LocationEntry& entry = m_locations.at(location_id);
+    if (entry.pose_valid && entry.status != LOC_REMOVED && entry.pose.map_id == m_map_name)
+        m_spatial.update(location_id, entry.pose.x, entry.pose.y);
+    else
+        m_spatial.remove(location_id);
+}
+
+
 /****************************************************************/
 bool NextLocPlanner::updateModule()
 {   
     
+    //the robot pose may come from the navigation server, so it is read without holding the lock
+    Map2DLocation robotLoc;
+    bool poseOk = getRobotPose(robotLoc);
+
     lock_guard<mutex> lock(m_mutex);
 
-    sortUncheckedLocations();
+    //the locations are ranked again only when needed: here we just check if the robot moved enough since the last ranking
+    if (poseOk && !m_ranking_stale && m_ranked_pose_valid)
+    {
+        double moved = sqrt(pow(robotLoc.x - m_ranked_pose.x, 2) + pow(robotLoc.y - m_ranked_pose.y, 2));
+        double turned = fabs(remainder(robotLoc.theta - m_ranked_pose.theta, 360.0));
+        if (moved > m_resort_distance || turned > m_resort_angle)
+            invalidateRanking();
+    }
+
+    //locations reserved by clients which stopped sending heartbeats are given back
+    vector<size_t> expired;
+    m_leases.expire(Time::now(), expired);
+    for (size_t id : expired)
+    {
+        const LocationEntry& entry = m_locations.at(id);
+        if (entry.status == LOC_CHECKING)
+        {
+            yCWarning(NEXT_LOC_PLANNER,"Lease on %s expired. Setting it back to unchecked", entry.name.c_str());
+            setLocationStatus(entry.name, "unchecked");
+        }
+        invalidateRanking();
+    }
+
+    unblockExpired();
+
+    //compact the journal of the changes into a new snapshot. It is rewritten even without changes,
+    // so that its time tells when the planner was last running and state_max_age does not discard an idle state
+    if (m_persist_state && Time::now() - m_last_snapshot_time > m_snapshot_period)
+    {
+        m_state.writeSnapshot(m_state_key, m_locations);
+        m_last_snapshot_time = Time::now();
+    }
+
+    if (m_view_dirty)
+        publishView();
     
     return true;
 }
 
 
+/****************************************************************/
+void NextLocPlanner::blockLocation(size_t location_id)
+{
+    //exponential backoff: each failure in a row doubles the time the location is skipped
+    BlockedLocation& blocked = m_blocked[location_id];     //zero failures if it was not blocked before
+    blocked.failures++;
+    double backoff = min(m_blocked_backoff * pow(2.0, blocked.failures - 1), m_blocked_backoff_max);
+    blocked.until = Time::now() + backoff;
+    yCWarning(NEXT_LOC_PLANNER,"Location %s not reachable (%d times in a row). Skipped for %.0f seconds", m_locations.at(location_id).name.c_str(), blocked.failures, backoff);
+}
+
+
+/****************************************************************/
+void NextLocPlanner::unblockExpired()
+{
+    //to be called holding the lock
+    double now = Time::now();
+    vector<size_t> expired;
+    for (const auto& blocked : m_blocked)
+    {
+        if (blocked.second.until <= now && m_locations.at(blocked.first).status == LOC_BLOCKED)
+            expired.push_back(blocked.first);
+    }
+    for (size_t id : expired)
+    {
+        yCInfo(NEXT_LOC_PLANNER,"Backoff of %s expired. Setting it back to unchecked", m_locations.at(id).name.c_str());
+        setLocationStatus(m_locations.at(id).name, "unchecked");
+    }
+}
+
+
+/****************************************************************/
+void NextLocPlanner::listBlocked(Bottle& reply)
+{
+    reply.addVocab32("many");
+    Bottle& results = reply.addList();
+    double now = Time::now();
+    for (const auto& blocked : m_blocked)
+    {
+        if (m_locations.at(blocked.first).status != LOC_BLOCKED)
+            continue;
+        Bottle& res = results.addList();
+        res.addString(m_locations.at(blocked.first).name);
+        res.addInt32(blocked.second.failures);
+        res.addFloat64(max(0.0, blocked.second.until - now));
+    }
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::getRobotPose(Map2DLocation& robotLoc)
+{
+    //the pose streamed by the localization server is used if available, otherwise it is requested
+    if (m_pose_listener.getPose(robotLoc))
+        return true;
+
+    return m_iNav2D->getCurrentPosition(robotLoc);
+}
+
+
 /****************************************************************/
 void NextLocPlanner::sortUncheckedLocations()
 {
-    vector<double> m_unchecked_dist;
-    for(size_t i=0; i<m_locations_unchecked.size(); ++i)
+    //asks the worker for a new ranking and waits for it
+    unique_lock<mutex> lock(m_mutex);
+    invalidateRanking();
+    waitForRanking(lock, -1.0);
+}
+
+
+/****************************************************************/
+void NextLocPlanner::invalidateRanking()
+{
+    //to be called holding the lock
+    m_ranking_stale = true;
+    m_view_dirty = true;
+    m_ranking_cv.notify_one();
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::waitForRanking(unique_lock<mutex>& lock, double timeout)
+{
+    //the ranking is up to date when nothing changed since the worker took its inputs and the worker is done
+    auto upToDate = [this]{ return m_stop_ranking || (!m_ranking_stale && !m_ranking_busy); };
+    if (timeout < 0)
+    {
+        m_ranked_cv.wait(lock, upToDate);
+        return true;
+    }
+    return m_ranked_cv.wait_for(lock, chrono::duration<double>(timeout), upToDate);
+}
+
+
+/****************************************************************/
+void NextLocPlanner::prepareRanking(const string& object)
+{
+    //the lock is released while waiting, so the worker and the other requests go on
+    unique_lock<mutex> lock(m_mutex);
+    if (object != m_search_object)
+    {
+        m_search_object = object;
+        invalidateRanking();
+    }
+
+    //no locations left: the worker looks for new frontiers on the map, which takes longer than a ranking
+    double timeout = m_ranking_wait;
+    if (m_exploration && m_locations.bucket(LOC_UNCHECKED).empty())
+    {
+        invalidateRanking();
+        timeout = max(m_ranking_wait, EXPLORATION_WAIT);
+    }
+
+    if (timeout > 0 && !waitForRanking(lock, timeout))
+        yCDebug(NEXT_LOC_PLANNER,"Ranking not ready after %.2f s. Answering from the last one", timeout);
+}
+
+
+/****************************************************************/
+void NextLocPlanner::rankingLoop()
+{
+    unique_lock<mutex> lock(m_mutex);
+    while (!m_stop_ranking)
+    {
+        m_ranking_cv.wait(lock, [this]{ return m_stop_ranking || m_ranking_stale; });
+        if (m_stop_ranking)
+            break;
+
+        //the inputs are copied holding the lock, the ranking is computed without it
+        m_ranking_stale = false;
+        m_ranking_busy = true;
+        RankingInput input;
+        input.table = m_locations;
+        input.area_of = m_areas.areaOfAll();
+        input.reset_tour = m_tour_reset_pending;
+        m_tour_reset_pending = false;
+        input.penalty.assign(m_locations.size(), 0.0);
+        input.prior.assign(m_locations.size(), -1.0);
+        bool usePriors = m_search_object != "" && m_priors.hasPriors(m_search_object);
+        for (size_t id : m_locations.bucket(LOC_UNCHECKED))
+        {
+            input.penalty[id] = reservationPenalty(id);
+            if (usePriors)
+                input.prior[id] = m_priors.probability(m_search_object, m_locations.at(id).name, m_locations.size());
+        }
+        input.use_priors = usePriors;
+
+        //the frontiers are extracted again when there are no other locations and either none is left or the robot explored one
+        input.gain.assign(m_locations.size(), -1.0);
+        size_t uncheckedFrontiers {0}, checkedFrontiers {0};
+        for (const auto& f : m_frontier_gain)
+        {
+            input.gain[f.first] = f.second;
+            LocationStatus status = m_locations.at(f.first).status;
+            uncheckedFrontiers += status == LOC_UNCHECKED ? 1 : 0;
+            checkedFrontiers += status == LOC_CHECKED ? 1 : 0;
+        }
+        bool otherLocations = m_locations.bucket(LOC_UNCHECKED).size() > uncheckedFrontiers;
+        input.explore = m_exploration && !otherLocations && (uncheckedFrontiers == 0 || checkedFrontiers != m_frontiers_checked);
+        input.next_frontier = m_frontier_count;
+        if (input.explore)
+            m_frontiers_checked = checkedFrontiers;
+        lock.unlock();
+
+        Map2DLocation robotLoc;
+        RankingOutput output;
+        bool ranked {true};
+        if (input.explore)
+            exploreFrontiers(input, output);
+        if (!output.explored && !input.table.bucket(LOC_UNCHECKED).empty())
+        {
+            ranked = getRobotPose(robotLoc);
+            if (ranked)
+                rankLocations(input, robotLoc, output);
+            else
+                yCWarning(NEXT_LOC_PLANNER,"Cannot retrieve the current robot position. Locations not sorted");
+        }
+
+        lock.lock();
+        if (output.robot_map != "" && output.robot_map != m_map_name)
+        {
+            //the robot moved to another map: nearest and within now refer to it
+            yCInfo(NEXT_LOC_PLANNER,"The robot is now on map %s", output.robot_map.c_str());
+            m_map_name = output.robot_map;
+            for (size_t id = 0; id < m_locations.size(); id++)
+                indexLocation(id);
+        }
+        for (size_t id : output.cached)
+        {
+            LocationEntry& entry = m_locations.at(id);
+            if (!entry.pose_valid)
+            {
+                entry.pose = input.table.at(id).pose;
+                entry.pose_valid = true;
+                indexLocation(id);
+            }
+        }
+        vector<string> removedFrontiers;
+        bool newFrontiers = output.explored && addFrontiers(input, output, removedFrontiers);
+        if (ranked)
+        {
+            if (!output.explored && !input.table.bucket(LOC_UNCHECKED).empty())
+            {
+                m_ranked_pose = robotLoc;
+                m_ranked_pose_valid = true;
+            }
+            applyRanking(output.order);
+            m_ranking = output;
+            publishView();
+        }
+        m_ranking_busy = false;
+        if (newFrontiers)
+            invalidateRanking();    //the new frontiers are ranked right away
+        m_ranked_cv.notify_all();
+
+        //the frontiers removed from the table are deleted from the map server without holding the lock
+        if (!removedFrontiers.empty())
+        {
+            lock.unlock();
+            for (const string& name : removedFrontiers)
+                m_iNav2D->deleteLocation(name);
+            lock.lock();
+        }
+    }
+}
+
+
+/****************************************************************/
+void NextLocPlanner::rankLocations(RankingInput& input, const Map2DLocation& robotLoc, RankingOutput& output)
+{
+    //runs on the worker, which is the only user of the travel costs and of the tour planner
+    LocationTable& table = input.table;
+    const vector<size_t>& unchecked = table.bucket(LOC_UNCHECKED);
+
+    //locations not cached yet: retrieved once from the map server
+    for (size_t id : unchecked)
+    {
+        LocationEntry& entry = table.at(id);
+        if (entry.pose_valid)
+            continue;
+        if (!m_iNav2D->getLocation(entry.name, entry.pose))
+        {
+            yCWarning(NEXT_LOC_PLANNER,"Cannot retrieve the coordinates of location %s from map server", entry.name.c_str());
+            continue;
+        }
+        entry.pose_valid = true;
+        output.cached.push_back(id);
+    }
+
+    if (input.reset_tour)
+        m_tour_planner.reset();
+    m_tour_planner.setAreas(input.area_of, m_area_switch_cost);
+
+    if (m_multi_map)
     {
-        m_unchecked_dist.push_back(distRobotLocation(m_locations_unchecked[i]));
+        followRobotMap(robotLoc);
+        output.robot_map = robotLoc.map_id;
     }
 
-    // Zip the vectors together
-    vector<pair<string,double>> zipped;
-    zip(m_locations_unchecked, m_unchecked_dist, zipped);
+    //the distance field is recomputed only if the robot moved enough from where it was last computed
+    bool robotMoved {false};
+    if (m_use_travel_distance && m_travel_cost.isValid() && (!m_multi_map || robotLoc.map_id == m_travel_cost.getMap().getMapName()))
+        robotMoved = m_travel_cost.update(robotLoc);
 
-    // Sort the vector of pairs
-    sort(begin(zipped), end(zipped), 
-        [&](const auto& a, const auto& b)
+    //cost of reaching the transitions of the robot map, then the other maps through them
+    if (m_multi_map)
+    {
+        m_map_graph.update(robotLoc, [this, &robotLoc](const Map2DLocation& portal)
+            {
+                double euclidean = sqrt(pow(robotLoc.x - portal.x, 2) + pow(robotLoc.y - portal.y, 2));
+                if (!m_use_travel_distance || !m_travel_cost.isValid() || portal.map_id != m_travel_cost.getMap().getMapName())
+                    return euclidean;
+                double travel = m_travel_cost.cost(portal);
+                return std::isinf(travel) ? euclidean : travel;
+            });
+    }
+
+    m_robot_cost.assign(table.size(), numeric_limits<double>::max());
+    output.robot_cost.assign(table.size(), numeric_limits<double>::quiet_NaN());
+    for (size_t id : unchecked)
+    {
+        m_robot_cost[id] = costRobotLocation(table, robotLoc, id) + input.penalty[id];
+        output.robot_cost[id] = m_robot_cost[id];
+    }
+
+    vector<pair<double,size_t>> ranked;
+    vector<pair<double,size_t>> frontiers;
+    ranked.reserve(unchecked.size());
+    bool toured = false;
+    bool exploring = any_of(unchecked.begin(), unchecked.end(), [&input](size_t id){ return id < input.gain.size() && input.gain[id] >= 0; });
+    if (exploring)
+    {
+        //the other locations first, closest first, then the frontiers with the highest information gain per travel cost
+        for (size_t id : unchecked)
+        {
+            if (input.gain[id] >= 0)
+                frontiers.push_back(make_pair(-input.gain[id] / max(m_robot_cost[id], MIN_PRIORS_COST), id));
+            else
+                ranked.push_back(make_pair(m_robot_cost[id], id));
+        }
+    }
+    else if (input.use_priors)
+    {
+        //expected time to find the object: the most likely locations first, weighted by how far they are
+        for (size_t id : unchecked)
+            ranked.push_back(make_pair(-input.prior[id] / max(m_robot_cost[id], MIN_PRIORS_COST), id));
+    }
+    else if (m_use_tour_planner && unchecked.size() <= m_tour_max_locations)
+    {
+        //the unchecked locations are visited following the planned tour
+        m_tour_planner.update(table, m_robot_cost, robotMoved);
+        output.order = m_tour_planner.tour();
+        toured = true;
+    }
+    else
+    {
+        for (size_t id : unchecked)
+            ranked.push_back(make_pair(m_robot_cost[id], id));
+    }
+
+    if (output.order.empty())
+    {
+        stable_sort(ranked.begin(), ranked.end(), [](const pair<double,size_t>& a, const pair<double,size_t>& b)
+            {
+                return a.first < b.first;
+            });
+        for (const auto& r : ranked)
+            output.order.push_back(r.second);
+    }
+    stable_sort(frontiers.begin(), frontiers.end(), [](const pair<double,size_t>& a, const pair<double,size_t>& b)
         {
-            return a.second < b.second;
+            return a.first < b.first;
         });
+    for (const auto& f : frontiers)
+        output.order.push_back(f.second);
+
+    //estimated cost to reach each location following the tour. The other orders are not evaluated:
+    //the direct cost from the robot is reported instead, without running the pairwise costs
+    output.cumulative.assign(table.size(), numeric_limits<double>::quiet_NaN());
+    output.total_cost = numeric_limits<double>::quiet_NaN();
+    if (!toured)
+        return;
+    vector<double> cumulative;
+    output.total_cost = m_tour_planner.evaluate(table, output.order, m_robot_cost, cumulative);
+    for (size_t i = 0; i < cumulative.size(); i++)
+        output.cumulative[output.order[i]] = cumulative[i];
+}
+
+
+/****************************************************************/
+void NextLocPlanner::followRobotMap(const Map2DLocation& robotLoc)
+{
+    //runs on the worker: when the robot changes map, the travel costs are computed on its new map
+    if (!m_use_travel_distance || (m_travel_cost.isValid() && robotLoc.map_id == m_travel_cost.getMap().getMapName()))
+        return;
+
+    MapGrid2D map;
+    if (!m_iNav2D->getCurrentNavigationMap(NavigationMapTypeEnum::global_map, map) || map.getMapName() != robotLoc.map_id || !m_travel_cost.setMap(map))
+    {
+        yCWarning(NEXT_LOC_PLANNER,"Cannot retrieve the global map %s: using straight-line distances on it", robotLoc.map_id.c_str());
+        return;
+    }
+    m_tour_planner.setCostMap(&m_travel_cost);
+}
+
+
+/****************************************************************/
+void NextLocPlanner::exploreFrontiers(const RankingInput& input, RankingOutput& output)
+{
+    //runs on the worker: the map and the map server are queried without holding the lock
+    MapGrid2D map;
+    if (!m_iNav2D->getCurrentNavigationMap(NavigationMapTypeEnum::global_map, map))
+    {
+        yCWarning(NEXT_LOC_PLANNER,"Cannot retrieve the global map: no frontiers to explore");
+        return;
+    }
+    output.explored = true;
+
+    //the frontiers not reached yet are replaced by the new ones: they are deleted from the map server by addFrontiers,
+    // once it is known which of them are still unchecked
+    vector<Frontier> found;
+    m_explorer.extract(map, found);
+    for (const Frontier& frontier : found)
+    {
+        //a frontier next to one the robot already went to is not explored again (the map may not be updated while searching)
+        bool visited {false};
+        for (size_t id = 0; id < input.gain.size() && !visited; id++)
+        {
+            const LocationEntry& entry = input.table.at(id);
+            visited = input.gain[id] >= 0 && entry.status != LOC_UNCHECKED && entry.status != LOC_REMOVED &&
+                      sqrt(pow(entry.pose.x - frontier.pose.x, 2) + pow(entry.pose.y - frontier.pose.y, 2)) < m_frontier_min_distance;
+        }
+        if (visited)
+            continue;
+
+        string name = FRONTIER_PREFIX + to_string(input.next_frontier + output.frontiers.size());
+        if (!m_iNav2D->storeLocation(name, frontier.pose))
+        {
+            yCWarning(NEXT_LOC_PLANNER,"Cannot store location %s in map server", name.c_str());
+            continue;
+        }
+        output.frontiers.push_back(frontier);
+        output.frontier_names.push_back(name);
+    }
+    yCInfo(NEXT_LOC_PLANNER,"%zu frontiers to explore on map %s", output.frontiers.size(), map.getMapName().c_str());
+}
+
+
+/****************************************************************/
+bool NextLocPlanner::addFrontiers(const RankingInput& input, const RankingOutput& output, vector<string>& removed)
+{
+    //to be called holding the lock: the old frontiers still unchecked are removed, the new ones added as unchecked locations.
+    //a frontier handed out by next while the worker was exploring is kept, since a robot may be going there
+    removed.clear();
+    for (size_t id = 0; id < input.gain.size(); id++)
+    {
+        if (input.gain[id] < 0 || m_locations.at(id).status != LOC_UNCHECKED)
+            continue;
+        removed.push_back(m_locations.at(id).name);
+        m_locations.setStatus(id, LOC_REMOVED);
+        m_spatial.remove(id);
+        m_frontier_gain.erase(id);
+        if (m_persist_state)
+            m_state.logStatus(m_locations.at(id).name, LOC_REMOVED);
+    }
+
+    for (size_t i = 0; i < output.frontiers.size(); i++)
+    {
+        size_t id = m_locations.add(output.frontier_names[i], output.frontiers[i].pose, true, m_area);
+        m_frontier_gain[id] = output.frontiers[i].gain;
+        m_areas.addLocation(id, output.frontier_names[i]);
+        indexLocation(id);
+        if (m_persist_state)
+            m_state.logAdd(m_locations.at(id));
+    }
+    m_frontier_count = input.next_frontier + output.frontiers.size();
+    m_view_dirty = true;
+
+    return !output.frontiers.empty();
+}
+
+
+/****************************************************************/
+void NextLocPlanner::restoreFrontiers()
+{
+    //frontiers generated before a restart: their gain is not known anymore, with the same gain they are ordered by travel cost
+    string prefix = FRONTIER_PREFIX;
+    for (size_t id = 0; id < m_locations.size(); id++)
+    {
+        const string& name = m_locations.at(id).name;
+        if (name.compare(0, prefix.size(), prefix) != 0 || name.find_first_not_of("0123456789", prefix.size()) != string::npos || name.size() == prefix.size())
+            continue;
+        m_frontier_gain[id] = 1.0;
+        m_frontier_count = max(m_frontier_count, (size_t)stoul(name.substr(prefix.size())) + 1);
+    }
+}
+
+
+/****************************************************************/
+void NextLocPlanner::applyRanking(const vector<size_t>& order)
+{
+    //the locations changed while the worker was ranking are kept: the ones no longer unchecked are dropped, the new ones go last
+    const vector<size_t>& unchecked = m_locations.bucket(LOC_UNCHECKED);
+    vector<bool> placed(m_locations.size(), false);
+    vector<size_t> merged;
+    merged.reserve(unchecked.size());
+    for (size_t id : order)
+    {
+        if (id < m_locations.size() && !placed[id] && m_locations.at(id).status == LOC_UNCHECKED)
+        {
+            merged.push_back(id);
+            placed[id] = true;
+        }
+    }
+    for (size_t id : unchecked)
+    {
+        if (!placed[id])
+            merged.push_back(id);
+    }
+    m_locations.reorderBucket(LOC_UNCHECKED, merged);
+}
+
+
+/****************************************************************/
+void NextLocPlanner::publishView()
+{
+    //to be called holding the lock
+    shared_ptr<const PlannerView> last = atomic_load(&m_view);
+    shared_ptr<PlannerView> view = make_shared<PlannerView>();
+    size_t n = m_locations.size();
+
+    if (last && last->names->size() == n)
+    {
+        view->names = last->names;
+        view->index = last->index;
+    }
+    else
+    {
+        auto names = make_shared<vector<string>>(n);
+        auto index = make_shared<unordered_map<string, size_t>>();
+        index->reserve(n);
+        for (size_t id = 0; id < n; id++)
+        {
+            (*names)[id] = m_locations.at(id).name;
+            (*index)[(*names)[id]] = id;
+        }
+        view->names = names;
+        view->index = index;
+    }
+
+    view->status.resize(n);
+    for (size_t id = 0; id < n; id++)
+        view->status[id] = m_locations.at(id).status;
+    for (int s = 0; s < LOC_STATUS_COUNT; s++)
+        view->buckets[s] = m_locations.bucket((LocationStatus)s);
 
-    // Write the sorted pairs back to the original vectors
-    unzip(zipped, m_locations_unchecked, m_unchecked_dist);
+    view->robot_cost = m_ranking.robot_cost;
+    view->cumulative = m_ranking.cumulative;
+    view->robot_cost.resize(n, numeric_limits<double>::quiet_NaN());
+    view->cumulative.resize(n, numeric_limits<double>::quiet_NaN());
+    view->total_cost = m_ranking.total_cost;
+
+    atomic_store(&m_view, shared_ptr<const PlannerView>(view));
+    m_view_dirty = false;
 }
 
 
 /****************************************************************/
 bool NextLocPlanner::removeLocation(string& location_name)
 {
-    vector<string>::iterator findUnchecked {find(m_locations_unchecked.begin(), m_locations_unchecked.end(), location_name)};
-    vector<string>::iterator findChecking {find(m_locations_checking.begin(), m_locations_checking.end(), location_name)};
-    vector<string>::iterator findChecked {find(m_locations_checked.begin(), m_locations_checked.end(), location_name)};
-    
-    if (findUnchecked != m_locations_unchecked.end())   { m_locations_unchecked.erase(findUnchecked);}
-    else if(findChecking != m_locations_checking.end()) { m_locations_checking.erase(findChecking);  }
-    else if(findChecked != m_locations_checked.end())   { m_locations_checked.erase(findChecked);    }
-    else 
+    size_t id = m_locations.id(location_name);
+    if (id == LocationTable::npos || m_locations.at(id).status == LOC_REMOVED)
         return false;
+
+    m_locations.setStatus(id, LOC_REMOVED);
+    m_spatial.remove(id);
+    m_leases.releaseLocation(id);
+    invalidateRanking();
+    if (m_persist_state)
+        m_state.logStatus(location_name, LOC_REMOVED);
     
     return true;
 }
@@ -555,12 +1960,17 @@ bool NextLocPlanner::removeLocation(string& location_name)
 /****************************************************************/
 bool NextLocPlanner::addLocation(string& location_name)
 {
-    vector<string>::iterator findLoc {find(m_all_locations.begin(), m_all_locations.end(), location_name)};
-    
-    if (findLoc != m_all_locations.end())   
-        m_locations_unchecked.push_back(location_name);
-    else 
+    size_t id = m_locations.id(location_name);
+    if (id == LocationTable::npos)   
         return false;
+
+    //a pose not cached yet is retrieved by the ranking worker, without holding the lock
+    m_locations.setStatus(id, LOC_UNCHECKED);
+    if (m_locations.at(id).pose_valid)
+        indexLocation(id);
+    invalidateRanking();
+    if (m_persist_state)
+        m_state.logStatus(location_name, LOC_UNCHECKED);
     
     return true;
 }
@@ -568,9 +1978,15 @@ bool NextLocPlanner::addLocation(string& location_name)
 /****************************************************************/
 bool NextLocPlanner::addLocation(string locName, Map2DLocation loc)
 {
-    m_iNav2D->storeLocation(locName, loc);
-    m_all_locations.push_back(locName);
-    m_locations_unchecked.push_back(locName);
+    //the location has already been stored in the map server by storeNewLocation
+    if (m_locations.contains(locName))
+        m_tour_reset_pending = true;    //the travel costs from the old coordinates are not valid anymore
+    size_t id = m_locations.add(locName, loc, true, m_area);
+    m_areas.addLocation(id, locName);
+    indexLocation(id);
+    invalidateRanking();
+    if (m_persist_state)
+        m_state.logAdd(m_locations.at(id));
 
     return true;
-}
\ No newline at end of file
+}
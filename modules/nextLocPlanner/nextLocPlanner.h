@@ -26,10 +26,26 @@
 #include <yarp/dev/PolyDriver.h>
 #include <yarp/os/Time.h>
 #include <yarp/os/Port.h>
+#include <yarp/os/BufferedPort.h>
 #include <yarp/dev/INavigation2D.h>
 #include <vector>
 #include <map>
 #include <algorithm>
+#include <memory>
+#include <thread>
+#include <condition_variable>
+#include "locationTable.h"
+#include "plannerView.h"
+#include "travelCostMap.h"
+#include "tourPlanner.h"
+#include "objectPriors.h"
+#include "plannerState.h"
+#include "robotPoseListener.h"
+#include "leaseTable.h"
+#include "areaIndex.h"
+#include "spatialIndex.h"
+#include "mapGraph.h"
+#include "frontierExplorer.h"
 
 using namespace yarp::os;
 using namespace yarp::dev;
@@ -37,13 +53,51 @@ using namespace yarp::dev::Nav2D;
 using namespace std;
 
 
+//Location the robot could not reach: it stays blocked until the backoff expires, which doubles at each failure
+struct BlockedLocation
+{
+    int     failures;
+    double  until;
+};
+
+//What the ranking worker needs, copied from the planner while holding the lock
+struct RankingInput
+{
+    LocationTable   table;
+    vector<int>     area_of;
+    vector<double>  penalty;        //by location id, for the reservations of the other robots
+    vector<double>  prior;          //by location id, probability of finding the searched object there
+    bool            use_priors;
+    bool            reset_tour;
+    vector<double>  gain;           //by location id, information gain of the frontiers, -1 for the other locations
+    bool            explore;        //the frontiers have to be extracted again
+    size_t          next_frontier;
+};
+
+struct RankingOutput
+{
+    vector<size_t>  order;
+    vector<double>  robot_cost;     //by location id
+    vector<double>  cumulative;     //by location id
+    double          total_cost {0.0};
+    vector<size_t>  cached;         //locations whose pose has been retrieved from the map server while ranking
+    string          robot_map;      //map the robot was on while ranking, if locations of several maps are planned
+    bool            explored {false};
+    vector<Frontier> frontiers;     //new frontiers, already stored in the map server
+    vector<string>  frontier_names;
+};
+
+
 class NextLocPlanner : public RFModule
 {
 
 private:  
     double            m_period;
     string            m_area;
-    string            m_map_name;
+    string            m_map_name;       //map the robot is on
+    bool              m_use_travel_distance;
+    bool              m_use_tour_planner;
+    size_t            m_tour_max_locations;
 
     //Devices
     PolyDriver        m_nav2DPoly;
@@ -51,12 +105,79 @@ private:
 
     //Ports
     RpcServer         m_rpc_server_port;
+    BufferedPort<Map2DLocation> m_localization_port;
+    RobotPoseListener m_pose_listener;
 
     //Locations
-    vector<string>    m_all_locations;
-    vector<string>    m_locations_unchecked;
-    vector<string>    m_locations_checking;
-    vector<string>    m_locations_checked;
+    LocationTable     m_locations;
+
+    //Travel distances on the global map
+    TravelCostMap     m_travel_cost;
+    vector<double>    m_robot_cost;     //cost to reach each location from the robot, as computed in the last ranking (used by the worker only)
+
+    //Route planning
+    TourPlanner       m_tour_planner;
+
+    //Where the objects have been found
+    ObjectPriors      m_priors;
+    string            m_search_object;  //object of the current search, if specified with 'next <object>'
+
+    //State saved to survive restarts
+    PlannerState      m_state;
+    bool              m_persist_state;
+    double            m_snapshot_period;
+    double            m_last_snapshot_time;
+
+    //Ranking, updated only when the robot moves or the locations change
+    bool              m_ranking_stale;
+    Map2DLocation     m_ranked_pose;
+    bool              m_ranked_pose_valid;
+    double            m_resort_distance;
+    double            m_resort_angle;
+
+    //Reservations, when several robots share the planner
+    LeaseTable        m_leases;
+    double            m_lease_radius;
+    double            m_lease_penalty;
+
+    //Locations not reachable, with their backoff
+    unordered_map<size_t, BlockedLocation> m_blocked;
+    double            m_blocked_backoff;
+    double            m_blocked_backoff_max;
+
+    //Areas hierarchy
+    AreaIndex         m_areas;
+    double            m_area_switch_cost;
+
+    //Grid over the location poses, for the nearest and within requests
+    SpatialIndex      m_spatial;
+
+    //Locations of all the maps of the building, connected by elevators and doors
+    bool              m_multi_map;
+    MapGraph          m_map_graph;
+    string            m_state_key;      //name under which the planner state is saved
+
+    //Exploration: frontiers of the map served as locations when there are no others
+    bool                        m_exploration;
+    FrontierExplorer            m_explorer;
+    double                      m_frontier_min_distance;
+    unordered_map<size_t,double> m_frontier_gain;     //location id -> information gain, for the generated locations
+    size_t                      m_frontier_count;       //used to name the generated locations
+    size_t                      m_frontiers_checked;    //checked frontiers when they were last extracted
+
+    //Ranking worker: the locations are ranked on a copy of the table, so that the lock is never held while waiting for the navigation server
+    thread              m_ranking_worker;
+    condition_variable  m_ranking_cv;       //wakes up the worker
+    condition_variable  m_ranked_cv;        //signals that a ranking has been applied
+    bool                m_stop_ranking;
+    bool                m_ranking_busy;
+    bool                m_tour_reset_pending;
+    double              m_ranking_wait;     //how long next waits for a stale ranking before answering from the last one
+    RankingOutput       m_ranking;
+
+    //Last published state, read without the lock
+    shared_ptr<const PlannerView> m_view;
+    bool                m_view_dirty;
     
     mutex             m_mutex;
 
@@ -64,6 +185,7 @@ public:
     NextLocPlanner();
     ~NextLocPlanner() = default;
     virtual bool configure(ResourceFinder &rf);
+    void setNavigation(INavigation2D* iNav2D); //to be called before configure() to use an already opened navigation interface
     virtual bool close();
     virtual double getPeriod();
     virtual bool updateModule();
@@ -75,30 +197,47 @@ public:
     void sortUncheckedLocations();
     bool removeLocation(string& loc);
     bool addLocation(string& loc); //add a previously defined location 
-    bool addLocation(string locName, Map2DLocation loc); //add a new location 
+    bool addLocation(string locName, Map2DLocation loc); //add a new location, already stored in the map server 
 
 private:
-    double distRobotLocation(const string& location_name);
-
-    template <typename A, typename B>
-    void zip(const vector<A> &a, const vector<B> &b,  vector<pair<A,B>> &zipped)
-    {
-        for(size_t i=0; i<a.size(); ++i)
-        {
-            zipped.push_back(make_pair(a[i], b[i]));
-        }
-    }
-
-    template <typename A, typename B>
-    void unzip(const vector<pair<A, B>> &zipped, vector<A> &a, vector<B> &b)
-    {
-        for(size_t i=0; i<a.size(); i++)
-        {
-            a[i] = zipped[i].first;
-            b[i] = zipped[i].second;
-        }
-    }
-
+    bool openNavigationClient(ResourceFinder &rf);
+    bool loadLocations();
+    bool respondFromView(const Bottle &cmd, Bottle &reply);
+    bool respondBatch(const Bottle &cmd, Bottle &reply);
+    bool respondNext(const Bottle &cmd, Bottle &reply);
+    bool respondLease(const Bottle &cmd, Bottle &reply);
+    void releaseCaller(const Bottle &cmd);
+    bool respondSpatial(const Bottle &cmd, Bottle &reply);
+    bool respondRoute(const Bottle &cmd, Bottle &reply);
+    void blockLocation(size_t location_id);
+    void unblockExpired();
+    void listBlocked(Bottle& reply);
+    void loadMapTransitions(ResourceFinder &rf);
+    void followRobotMap(const Map2DLocation& robotLoc);
+    void exploreFrontiers(const RankingInput& input, RankingOutput& output);
+    bool addFrontiers(const RankingInput& input, const RankingOutput& output, vector<string>& removed);
+    void restoreFrontiers();
+    bool isNextOption(const string& token);
+    bool parsePose(const Value& value, Map2DLocation& pose);
+    bool parseArea(const string& token, vector<int>& areas);
+    bool setAreaStatus(const vector<int>& areas, const string& location_status);
+    void listAreas(Bottle& reply);
+    double distRobotLocation(const LocationTable& table, const Map2DLocation& robotLoc, size_t location_id);
+    double reservationPenalty(size_t location_id);
+    vector<size_t>::const_iterator closestToClient(const vector<size_t>& unchecked, const vector<int>* areas, const Map2DLocation& from);
+    double costRobotLocation(const LocationTable& table, const Map2DLocation& robotLoc, size_t location_id);
+    bool getNextLocation(string& location_name, const vector<int>* areas = nullptr, const Map2DLocation* from = nullptr);
+    void recordObjectFound(const string& location_name, const string& object);
+    bool getRobotPose(Map2DLocation& robotLoc);
+    void invalidateRanking();
+    bool waitForRanking(unique_lock<mutex>& lock, double timeout);
+    void prepareRanking(const string& object);
+    void rankingLoop();
+    void rankLocations(RankingInput& input, const Map2DLocation& robotLoc, RankingOutput& output);
+    void applyRanking(const vector<size_t>& order);
+    void publishView();
+    bool storeNewLocation(const Bottle &cmd, Map2DLocation& loc);
+    void indexLocation(size_t location_id);
 
 };
 
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <fstream>
+#include <sstream>
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include "objectPriors.h"
+
+YARP_LOG_COMPONENT(OBJECT_PRIORS, "r1_obr.nextLocPlanner.objectPriors")
+
+/****************************************************************/
+ObjectPriors::ObjectPriors() :
+    m_file(""),
+    m_alpha(1.0)
+{
+}
+
+/****************************************************************/
+void ObjectPriors::setSmoothing(double alpha)
+{
+    m_alpha = alpha > 0.0 ? alpha : 1.0;
+}
+
+/****************************************************************/
+bool ObjectPriors::load(const string& file)
+{
+    m_file = file;
+    m_counts.clear();
+    m_totals.clear();
+
+    ifstream in(m_file);
+    if (!in.is_open())
+    {
+        yCInfo(OBJECT_PRIORS, "No object priors file found in %s. Starting without priors", m_file.c_str());
+        return false;
+    }
+
+    string line;
+    while (getline(in, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        stringstream ss(line);
+        string object, location;
+        int n {0};
+        if (!(ss >> object >> location >> n) || n <= 0)
+            continue;
+
+        m_counts[object][location] += n;
+        m_totals[object] += n;
+    }
+
+    yCInfo(OBJECT_PRIORS, "Loaded priors for %zu objects from %s", m_counts.size(), m_file.c_str());
+    return true;
+}
+
+/****************************************************************/
+bool ObjectPriors::save() const
+{
+    if (m_file == "")
+        return false;
+
+    ofstream out(m_file, ios::trunc);
+    if (!out.is_open())
+    {
+        yCWarning(OBJECT_PRIORS, "Cannot write the object priors file %s", m_file.c_str());
+        return false;
+    }
+
+    out << "# <object> <location> <times found>" << endl;
+    for (const auto& obj : m_counts)
+    {
+        for (const auto& loc : obj.second)
+            out << obj.first << " " << loc.first << " " << loc.second << endl;
+    }
+    return true;
+}
+
+/****************************************************************/
+void ObjectPriors::record(const string& object, const string& location)
+{
+    m_counts[object][location]++;
+    m_totals[object]++;
+}
+
+/****************************************************************/
+bool ObjectPriors::hasPriors(const string& object) const
+{
+    return m_totals.find(object) != m_totals.end();
+}
+
+/****************************************************************/
+int ObjectPriors::count(const string& object, const string& location) const
+{
+    auto obj = m_counts.find(object);
+    if (obj == m_counts.end())
+        return 0;
+
+    auto loc = obj->second.find(location);
+    return loc == obj->second.end() ? 0 : loc->second;
+}
+
+/****************************************************************/
+double ObjectPriors::probability(const string& object, const string& location, size_t n_locations) const
+{
+    if (n_locations == 0)
+        return 0.0;
+
+    auto tot = m_totals.find(object);
+    int total = tot == m_totals.end() ? 0 : tot->second;
+
+    return (count(object, location) + m_alpha) / (total + m_alpha * n_locations);
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef OBJECT_PRIORS_H
+#define OBJECT_PRIORS_H
+
+#include <string>
+#include <map>
+
+using namespace std;
+
+/**
+ * Counts how many times each object has been found at each location, so that the search for an object
+ * can start from the locations where it has been found before.
+ * The counts are stored in a text file, one "<object> <location> <count>" entry per line.
+ */
+class ObjectPriors
+{
+private:
+    map<string, map<string, int>>   m_counts;   //object -> location -> times found
+    map<string, int>                m_totals;   //object -> times found
+    string                          m_file;
+    double                          m_alpha;    //additive smoothing, so that locations never found keep a non-zero probability
+
+public:
+    ObjectPriors();
+    ~ObjectPriors() = default;
+
+    void    setSmoothing(double alpha);
+    bool    load(const string& file);
+    bool    save() const;
+
+    void    record(const string& object, const string& location);
+    bool    hasPriors(const string& object) const;
+    double  probability(const string& object, const string& location, size_t n_locations) const;
+    int     count(const string& object, const string& location) const;
+};
+
+#endif
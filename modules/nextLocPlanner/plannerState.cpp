@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Time.h>
+#include "plannerState.h"
+
+YARP_LOG_COMPONENT(PLANNER_STATE, "r1_obr.nextLocPlanner.plannerState")
+
+/****************************************************************/
+PlannerState::PlannerState() :
+    m_snapshot_file(""),
+    m_journal_file(""),
+    m_journal_entries(0)
+{
+}
+
+/****************************************************************/
+PlannerState::~PlannerState()
+{
+    close();
+}
+
+/****************************************************************/
+bool PlannerState::open(const string& state_dir)
+{
+    //without a state folder (e.g. no home context path) the files go in the working directory, not in the root
+    string dir = state_dir == "" ? "." : state_dir;
+    m_snapshot_file = dir + "/nextLocPlanner_snapshot.txt";
+    m_journal_file = dir + "/nextLocPlanner_journal.txt";
+
+    //a crash while writing may have left a truncated last entry: new entries must start on a new line
+    bool truncated {false};
+    {
+        ifstream in(m_journal_file, ios::binary | ios::ate);
+        if (in.is_open() && in.tellg() > 0)
+        {
+            in.seekg(-1, ios::end);
+            truncated = in.get() != '\n';
+        }
+    }
+
+    m_journal.open(m_journal_file, ios::app);
+    if (!m_journal.is_open())
+    {
+        yCWarning(PLANNER_STATE, "Cannot open the journal file %s. The planner state will not be saved", m_journal_file.c_str());
+        return false;
+    }
+    if (truncated)
+        m_journal << endl;
+    return true;
+}
+
+/****************************************************************/
+void PlannerState::close()
+{
+    if (m_journal.is_open())
+        m_journal.close();
+}
+
+/****************************************************************/
+size_t PlannerState::pendingEntries() const
+{
+    return m_journal_entries;
+}
+
+/****************************************************************/
+bool PlannerState::append(const string& entry)
+{
+    if (!m_journal.is_open())
+        return false;
+
+    m_journal << fixed << setprecision(3) << yarp::os::Time::now() << " " << entry << endl;  //endl flushes each entry
+    m_journal_entries++;
+    return m_journal.good();
+}
+
+/****************************************************************/
+bool PlannerState::logStatus(const string& location_name, LocationStatus status)
+{
+    return append("status " + location_name + " " + LocationTable::statusName(status));
+}
+
+/****************************************************************/
+bool PlannerState::logAllStatus(LocationStatus status)
+{
+    return append("all " + LocationTable::statusName(status));
+}
+
+/****************************************************************/
+bool PlannerState::logAdd(const LocationEntry& entry)
+{
+    stringstream ss;
+    ss << setprecision(9) << "add " << entry.name << " " << entry.pose.map_id << " " << entry.pose.x << " " << entry.pose.y << " " << entry.pose.theta
+       << " " << LocationTable::statusName(entry.status) << " " << (entry.area == "" ? "-" : entry.area);
+    return append(ss.str());
+}
+
+/****************************************************************/
+bool PlannerState::writeSnapshot(const string& map_name, const LocationTable& table)
+{
+    if (m_snapshot_file == "")
+        return false;
+
+    //the snapshot is written to a temporary file and then renamed, so that a crash never leaves a partial snapshot
+    string tmp_file = m_snapshot_file + ".tmp";
+    {
+        ofstream out(tmp_file, ios::trunc);
+        if (!out.is_open())
+        {
+            yCWarning(PLANNER_STATE, "Cannot write the snapshot file %s", tmp_file.c_str());
+            return false;
+        }
+
+        out << "map " << map_name << endl;
+        out << fixed << setprecision(3) << "time " << yarp::os::Time::now() << endl;
+        out << setprecision(9);
+        for (size_t id = 0; id < table.size(); id++)
+        {
+            const LocationEntry& entry = table.at(id);
+            if (!entry.pose_valid)
+                continue;
+            out << "loc " << entry.name << " " << entry.pose.map_id << " " << entry.pose.x << " " << entry.pose.y << " " << entry.pose.theta
+                << " " << LocationTable::statusName(entry.status) << " " << (entry.area == "" ? "-" : entry.area) << endl;
+        }
+        out << "end" << endl;
+        if (!out.good())
+            return false;
+    }
+
+    if (rename(tmp_file.c_str(), m_snapshot_file.c_str()) != 0)
+    {
+        yCWarning(PLANNER_STATE, "Cannot replace the snapshot file %s", m_snapshot_file.c_str());
+        return false;
+    }
+
+    //everything in the journal is now part of the snapshot
+    if (m_journal.is_open())
+        m_journal.close();
+    m_journal.open(m_journal_file, ios::trunc);
+    m_journal_entries = 0;
+
+    return true;
+}
+
+/****************************************************************/
+bool PlannerState::applyJournalLine(const string& line, LocationTable& table) const
+{
+    stringstream ss(line);
+    double t;
+    string op;
+    if (!(ss >> t >> op))
+        return false;
+
+    LocationStatus status;
+    if (op == "status")
+    {
+        string name, status_name;
+        if (!(ss >> name >> status_name) || !LocationTable::parseStatusName(status_name, status))
+            return false;
+        size_t id = table.id(name);
+        if (id == LocationTable::npos)
+            return false;
+        table.setStatus(id, status);
+    }
+    else if (op == "all")
+    {
+        string status_name;
+        if (!(ss >> status_name) || !LocationTable::parseStatusName(status_name, status))
+            return false;
+        table.setAllStatus(status);
+    }
+    else if (op == "add")
+    {
+        string name, map_id, status_name, area;
+        double x, y, th;
+        if (!(ss >> name >> map_id >> x >> y >> th >> status_name >> area) || !LocationTable::parseStatusName(status_name, status))
+            return false;
+        table.add(name, Map2DLocation(map_id, x, y, th), true, area == "-" ? "" : area, status);
+    }
+    else
+        return false;
+
+    return true;
+}
+
+/****************************************************************/
+bool PlannerState::load(const string& map_name, double max_age, LocationTable& table)
+{
+    ifstream in(m_snapshot_file);
+    if (!in.is_open())
+        return false;
+
+    string line, key, value;
+    double snapshot_time {0.0};
+    bool completed {false};
+    LocationTable loaded;
+
+    getline(in, line);
+    stringstream header(line);
+    if (!(header >> key >> value) || key != "map" || value != map_name)
+    {
+        yCInfo(PLANNER_STATE, "The saved planner state refers to another map. Ignoring it");
+        return false;
+    }
+
+    while (getline(in, line))
+    {
+        stringstream ss(line);
+        if (!(ss >> key))
+            continue;
+
+        if (key == "time")
+            ss >> snapshot_time;
+        else if (key == "loc")
+        {
+            string name, map_id, status_name, area;
+            double x, y, th;
+            LocationStatus status;
+            if (!(ss >> name >> map_id >> x >> y >> th >> status_name >> area) || !LocationTable::parseStatusName(status_name, status))
+                continue;
+            loaded.add(name, Map2DLocation(map_id, x, y, th), true, area == "-" ? "" : area, status);
+        }
+        else if (key == "end")
+            completed = true;
+    }
+
+    if (!completed)
+    {
+        yCWarning(PLANNER_STATE, "The saved snapshot %s is incomplete. Ignoring it", m_snapshot_file.c_str());
+        return false;
+    }
+
+    if (max_age > 0 && yarp::os::Time::now() - snapshot_time > max_age)
+    {
+        yCInfo(PLANNER_STATE, "The saved planner state is older than %.0f seconds. Ignoring it", max_age);
+        return false;
+    }
+
+    //replay the changes happened after the snapshot. A truncated last line (crash while writing) is simply skipped
+    size_t replayed {0};
+    ifstream journal(m_journal_file);
+    while (journal.is_open() && getline(journal, line))
+    {
+        if (applyJournalLine(line, loaded))
+            replayed++;
+    }
+
+    table = loaded;
+    m_journal_entries = replayed;
+    yCInfo(PLANNER_STATE, "Restored %zu locations from the saved state (%zu journal entries replayed)", table.size(), replayed);
+
+    return true;
+}
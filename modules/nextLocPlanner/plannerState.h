@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef PLANNER_STATE_H
+#define PLANNER_STATE_H
+
+#include <string>
+#include <fstream>
+#include "locationTable.h"
+
+using namespace std;
+
+/**
+ * Persistent state of the planner, used to restart it without losing the status of the locations.
+ * Every change of the locations table is appended to a journal file. Periodically a compact snapshot
+ * of the whole table is written and the journal is truncated.
+ * On restart the snapshot is loaded and the journal is replayed on top of it, so the locations do not
+ * need to be requested again to the map server.
+ */
+class PlannerState
+{
+private:
+    string      m_snapshot_file;
+    string      m_journal_file;
+    ofstream    m_journal;
+    size_t      m_journal_entries;
+
+    bool        applyJournalLine(const string& line, LocationTable& table) const;
+    bool        append(const string& entry);
+
+public:
+    PlannerState();
+    ~PlannerState();
+
+    bool        open(const string& state_dir);
+    void        close();
+
+    bool        load(const string& map_name, double max_age, LocationTable& table);
+    bool        writeSnapshot(const string& map_name, const LocationTable& table);
+    size_t      pendingEntries() const;
+
+    bool        logStatus(const string& location_name, LocationStatus status);
+    bool        logAllStatus(LocationStatus status);
+    bool        logAdd(const LocationEntry& entry);
+};
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef PLANNER_VIEW_H
+#define PLANNER_VIEW_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "locationTable.h"
+
+using namespace std;
+
+/**
+ * Immutable copy of the locations status and of their last ranking, published by the planner after every change.
+ * The read-only requests (find, list, plan ...) are answered from the last published view without taking the planner lock.
+ * Names and index only change when a location is added, so they are shared by the views instead of being copied every time.
+ */
+struct PlannerView
+{
+    shared_ptr<const vector<string>>                    names;          //by location id
+    shared_ptr<const unordered_map<string, size_t>>     index;          //location name -> id
+    vector<LocationStatus>                              status;         //by location id
+    vector<size_t>                                      buckets[LOC_STATUS_COUNT];
+    vector<double>                                      robot_cost;     //by location id: cost to reach it from the robot, NaN if not ranked
+    vector<double>                                      cumulative;     //by location id: cost to reach it following the order, NaN if not evaluated
+    double                                              total_cost;
+
+    size_t find(const string& name) const
+    {
+        auto it = index->find(name);
+        return it == index->end() ? LocationTable::npos : it->second;
+    }
+};
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <yarp/os/Time.h>
+#include "robotPoseListener.h"
+
+/****************************************************************/
+RobotPoseListener::RobotPoseListener() :
+    TypedReaderCallback(),
+    m_stamp(-1.0),
+    m_timeout(1.0)
+{
+}
+
+/****************************************************************/
+void RobotPoseListener::onRead(Map2DLocation& loc)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_pose = loc;
+    m_stamp = Time::now();
+}
+
+/****************************************************************/
+void RobotPoseListener::setTimeout(double timeout)
+{
+    m_timeout = timeout;
+}
+
+/****************************************************************/
+bool RobotPoseListener::getPose(Map2DLocation& loc)
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_stamp < 0 || Time::now() - m_stamp > m_timeout)
+        return false;   //nothing received yet, or the stream stopped
+
+    loc = m_pose;
+    return true;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef ROBOT_POSE_LISTENER_H
+#define ROBOT_POSE_LISTENER_H
+
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/TypedReaderCallback.h>
+#include <yarp/dev/INavigation2D.h>
+#include <mutex>
+
+using namespace yarp::os;
+using namespace yarp::dev::Nav2D;
+using namespace std;
+
+/**
+ * Keeps the last robot pose streamed by the localization server, so that the planner can follow the robot motion
+ * without sending any request to the navigation server.
+ */
+class RobotPoseListener : public TypedReaderCallback<Map2DLocation>
+{
+private:
+    mutex           m_mutex;
+    Map2DLocation   m_pose;
+    double          m_stamp;
+    double          m_timeout;
+
+public:
+    RobotPoseListener();
+    ~RobotPoseListener() = default;
+
+    using TypedReaderCallback<Map2DLocation>::onRead;
+    void onRead(Map2DLocation& loc) override;
+
+    void setTimeout(double timeout);
+    bool getPose(Map2DLocation& loc);
+};
+
+#endif
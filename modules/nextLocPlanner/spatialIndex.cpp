@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "spatialIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+const int64_t SpatialIndex::EMPTY = numeric_limits<int64_t>::min();
+
+/****************************************************************/
+SpatialIndex::SpatialIndex() :
+    m_cell_size(1.0),
+    m_min_cx(0),
+    m_max_cx(0),
+    m_min_cy(0),
+    m_max_cy(0),
+    m_count(0)
+{
+}
+
+/****************************************************************/
+void SpatialIndex::setCellSize(double size)
+{
+    //to be called before adding any location
+    if (size > 0)
+        m_cell_size = size;
+}
+
+/****************************************************************/
+int64_t SpatialIndex::key(int cx, int cy) const
+{
+    return (int64_t)(((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy);
+}
+
+/****************************************************************/
+int SpatialIndex::cellCoord(double v) const
+{
+    return (int)floor(v / m_cell_size);
+}
+
+/****************************************************************/
+void SpatialIndex::update(size_t id, double x, double y)
+{
+    remove(id);
+    if (id >= m_cell_of.size())
+    {
+        m_cell_of.resize(id + 1, EMPTY);
+        m_x.resize(id + 1, 0.0);
+        m_y.resize(id + 1, 0.0);
+    }
+
+    int cx = cellCoord(x);
+    int cy = cellCoord(y);
+    if (m_count == 0 && m_cells.empty())
+    {
+        m_min_cx = m_max_cx = cx;
+        m_min_cy = m_max_cy = cy;
+    }
+    m_min_cx = min(m_min_cx, cx);
+    m_max_cx = max(m_max_cx, cx);
+    m_min_cy = min(m_min_cy, cy);
+    m_max_cy = max(m_max_cy, cy);
+
+    int64_t k = key(cx, cy);
+    m_cells[k].push_back(id);
+    m_cell_of[id] = k;
+    m_x[id] = x;
+    m_y[id] = y;
+    m_count++;
+}
+
+/****************************************************************/
+void SpatialIndex::remove(size_t id)
+{
+    if (id >= m_cell_of.size() || m_cell_of[id] == EMPTY)
+        return;
+
+    auto it = m_cells.find(m_cell_of[id]);
+    vector<size_t>& ids = it->second;
+    ids.erase(find(ids.begin(), ids.end(), id));
+    if (ids.empty())
+        m_cells.erase(it);
+    m_cell_of[id] = EMPTY;
+    m_count--;
+}
+
+/****************************************************************/
+void SpatialIndex::clear()
+{
+    m_cells.clear();
+    m_cell_of.clear();
+    m_x.clear();
+    m_y.clear();
+    m_count = 0;
+}
+
+/****************************************************************/
+size_t SpatialIndex::size() const
+{
+    return m_count;
+}
+
+/****************************************************************/
+void SpatialIndex::visitCell(int cx, int cy, double x, double y, vector<pair<double,size_t>>& found) const
+{
+    auto it = m_cells.find(key(cx, cy));
+    if (it == m_cells.end())
+        return;
+
+    for (size_t id : it->second)
+        found.push_back(make_pair(sqrt(pow(m_x[id] - x, 2) + pow(m_y[id] - y, 2)), id));
+}
+
+/****************************************************************/
+void SpatialIndex::nearest(double x, double y, size_t k, vector<pair<double,size_t>>& result) const
+{
+    result.clear();
+    if (k == 0 || m_count == 0)
+        return;
+
+    int cx = cellCoord(x);
+    int cy = cellCoord(y);
+    int lastRing = max(max(abs(cx - m_min_cx), abs(cx - m_max_cx)), max(abs(cy - m_min_cy), abs(cy - m_max_cy)));
+
+    for (int ring = 0; ring <= lastRing; ring++)
+    {
+        size_t ringCells = ring == 0 ? 1 : 8 * (size_t)ring;
+        if (ringCells > m_cells.size())
+        {
+            //sparse locations: cheaper to look at the remaining occupied cells than at the empty ones of the ring
+            for (const auto& cell : m_cells)
+            {
+                int ccx = (int32_t)(uint32_t)((uint64_t)cell.first >> 32);
+                int ccy = (int32_t)(uint32_t)((uint64_t)cell.first);
+                if (max(abs(ccx - cx), abs(ccy - cy)) >= ring)
+                    visitCell(ccx, ccy, x, y, result);
+            }
+            break;
+        }
+
+        if (ring == 0)
+            visitCell(cx, cy, x, y, result);
+        for (int d = -ring; ring > 0 && d < ring; d++)
+        {
+            visitCell(cx + d, cy - ring, x, y, result);
+            visitCell(cx + ring, cy + d, x, y, result);
+            visitCell(cx - d, cy + ring, x, y, result);
+            visitCell(cx - ring, cy - d, x, y, result);
+        }
+
+        //the locations beyond this ring are at least ring cells away from the query point
+        if (result.size() >= k)
+        {
+            nth_element(result.begin(), result.begin() + (k - 1), result.end());
+            if (result[k - 1].first <= ring * m_cell_size)
+                break;
+        }
+    }
+
+    size_t n = min(k, result.size());
+    partial_sort(result.begin(), result.begin() + n, result.end());
+    result.resize(n);
+}
+
+/****************************************************************/
+void SpatialIndex::within(double x, double y, double radius, vector<pair<double,size_t>>& result) const
+{
+    result.clear();
+    if (radius < 0 || m_count == 0)
+        return;
+
+    int minCx = max(cellCoord(x - radius), m_min_cx);
+    int maxCx = min(cellCoord(x + radius), m_max_cx);
+    int minCy = max(cellCoord(y - radius), m_min_cy);
+    int maxCy = min(cellCoord(y + radius), m_max_cy);
+    if (minCx > maxCx || minCy > maxCy)
+        return;
+
+    if ((double)(maxCx - minCx + 1) * (maxCy - minCy + 1) > m_cells.size())
+    {
+        for (const auto& cell : m_cells)
+            visitCell((int32_t)(uint32_t)((uint64_t)cell.first >> 32), (int32_t)(uint32_t)((uint64_t)cell.first), x, y, result);
+    }
+    else
+    {
+        for (int i = minCx; i <= maxCx; i++)
+            for (int j = minCy; j <= maxCy; j++)
+                visitCell(i, j, x, y, result);
+    }
+
+    result.erase(remove_if(result.begin(), result.end(), [radius](const pair<double,size_t>& r){ return r.first > radius; }), result.end());
+    sort(result.begin(), result.end());
+}
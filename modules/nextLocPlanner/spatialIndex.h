@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * Uniform grid over the poses of the locations, for radius and nearest-neighbour queries.
+ * Each location is stored in the cell containing it: a query only visits the cells around the query point,
+ * expanding ring by ring for the nearest ones, so its cost depends on the local density of the locations and not on their number.
+ * When the rings to visit would hold more cells than the occupied ones, the occupied cells are scanned instead.
+ */
+class SpatialIndex
+{
+private:
+    unordered_map<int64_t, vector<size_t>>  m_cells;
+    vector<int64_t>                         m_cell_of;      //location id -> cell key, EMPTY if not indexed
+    vector<double>                          m_x;
+    vector<double>                          m_y;
+    double                                  m_cell_size;
+    int                                     m_min_cx, m_max_cx, m_min_cy, m_max_cy;    //bounds of the cells used so far
+    size_t                                  m_count;
+
+    static const int64_t EMPTY;
+
+    int64_t key(int cx, int cy) const;
+    int     cellCoord(double v) const;
+    void    visitCell(int cx, int cy, double x, double y, vector<pair<double,size_t>>& found) const;
+
+public:
+    SpatialIndex();
+    ~SpatialIndex() = default;
+
+    void    setCellSize(double size);
+    void    update(size_t id, double x, double y);
+    void    remove(size_t id);
+    void    clear();
+    size_t  size() const;
+
+    void    nearest(double x, double y, size_t k, vector<pair<double,size_t>>& result) const;
+    void    within(double x, double y, double radius, vector<pair<double,size_t>>& result) const;
+};
+
+#endif
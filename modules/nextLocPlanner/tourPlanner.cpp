@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <math.h>
+#include <limits>
+#include <algorithm>
+#include "tourPlanner.h"
+
+#define IMPROVEMENT_EPS 1e-6
+
+/****************************************************************/
+TourPlanner::TourPlanner() :
+    m_cost_map(nullptr),
+    m_map_graph(nullptr),
+    m_tour_cost(0.0),
+    m_max_passes(5),
+    m_unreachable_cost(1.0e6),
+    m_area_switch_cost(0.0)
+{
+}
+
+/****************************************************************/
+void TourPlanner::setCostMap(const TravelCostMap* cost_map)
+{
+    m_cost_map = cost_map;
+    reset();
+}
+
+/****************************************************************/
+void TourPlanner::setMapGraph(const MapGraph* map_graph)
+{
+    m_map_graph = map_graph;
+    reset();
+}
+
+/****************************************************************/
+void TourPlanner::setMaxPasses(int passes)
+{
+    m_max_passes = max(0, passes);
+}
+
+/****************************************************************/
+void TourPlanner::setUnreachableCost(double cost)
+{
+    m_unreachable_cost = cost;
+}
+
+/****************************************************************/
+void TourPlanner::setAreas(const vector<int>& area_of, double switch_cost)
+{
+    m_area_of = area_of;
+    m_area_switch_cost = switch_cost;
+}
+
+/****************************************************************/
+void TourPlanner::reset()
+{
+    m_rows.clear();
+    m_tour.clear();
+    m_tour_cost = 0.0;
+}
+
+/****************************************************************/
+const vector<size_t>& TourPlanner::tour() const
+{
+    return m_tour;
+}
+
+/****************************************************************/
+double TourPlanner::tourCost() const
+{
+    return m_tour_cost;
+}
+
+/****************************************************************/
+double TourPlanner::pairCost(const LocationTable& table, size_t from, size_t to)
+{
+    if (from == to)
+        return 0.0;
+
+    //the costs are considered symmetric: each pair is stored once, in the row of the location with the higher id
+    size_t row_id = max(from, to);
+    size_t col_id = min(from, to);
+
+    auto it = m_rows.find(row_id);
+    if (it == m_rows.end())
+    {
+        const LocationEntry& row_entry = table.at(row_id);
+        vector<float> row(row_id, numeric_limits<float>::quiet_NaN());
+
+        vector<float> field;
+        bool fieldOk = m_cost_map && m_cost_map->isValid() && row_entry.pose_valid && row_entry.pose.map_id == m_cost_map->getMap().getMapName()
+                       && m_cost_map->computeField(row_entry.pose, field);
+        for (size_t j = 0; j < row_id; j++)
+        {
+            const LocationEntry& entry = table.at(j);
+            if (!row_entry.pose_valid || !entry.pose_valid)
+            {
+                row[j] = (float)m_unreachable_cost;
+                continue;
+            }
+
+            double euclidean = sqrt(pow(row_entry.pose.x - entry.pose.x, 2) + pow(row_entry.pose.y - entry.pose.y, 2));
+            if (m_map_graph && entry.pose.map_id != row_entry.pose.map_id)
+            {
+                double through = m_map_graph->between(row_entry.pose, entry.pose);
+                row[j] = (float)(std::isinf(through) ? m_unreachable_cost + euclidean : through);
+                continue;
+            }
+            if (!fieldOk)
+            {
+                row[j] = (float)euclidean;
+                continue;
+            }
+
+            double travel = m_cost_map->lookup(field, entry.pose);
+            row[j] = (float)(std::isinf(travel) ? m_unreachable_cost + euclidean : travel);
+        }
+        it = m_rows.insert(make_pair(row_id, row)).first;
+    }
+
+    return it->second[col_id];
+}
+
+/****************************************************************/
+double TourPlanner::legCost(const LocationTable& table, const vector<double>& robot_cost, long from, long to)
+{
+    //from < 0 is the robot, to < 0 is the end of the tour (which is an open path)
+    if (to < 0)
+        return 0.0;
+    if (from < 0)
+        return robot_cost[to];
+
+    double cost = pairCost(table, (size_t)from, (size_t)to);
+    if (m_area_switch_cost > 0 && (size_t)max(from, to) < m_area_of.size() && m_area_of[from] != m_area_of[to])
+        cost += m_area_switch_cost;
+    return cost;
+}
+
+/****************************************************************/
+void TourPlanner::insertCheapest(const LocationTable& table, size_t node, const vector<double>& robot_cost)
+{
+    size_t best_pos = 0;
+    double best_delta = numeric_limits<double>::max();
+    for (size_t p = 0; p <= m_tour.size(); p++)
+    {
+        long prev = p == 0 ? -1 : (long)m_tour[p-1];
+        long next = p == m_tour.size() ? -1 : (long)m_tour[p];
+        double delta = legCost(table, robot_cost, prev, node) + legCost(table, robot_cost, node, next) - legCost(table, robot_cost, prev, next);
+        if (delta < best_delta)
+        {
+            best_delta = delta;
+            best_pos = p;
+        }
+    }
+    m_tour.insert(m_tour.begin() + best_pos, node);
+}
+
+/****************************************************************/
+void TourPlanner::build(const LocationTable& table, const vector<size_t>& nodes, const vector<double>& robot_cost)
+{
+    m_tour.clear();
+    if (nodes.empty())
+        return;
+
+    //start from the location closest to the robot
+    vector<size_t> remaining = nodes;
+    size_t first = 0;
+    for (size_t i = 1; i < remaining.size(); i++)
+    {
+        if (robot_cost[remaining[i]] < robot_cost[remaining[first]])
+            first = i;
+    }
+    m_tour.push_back(remaining[first]);
+    remaining.erase(remaining.begin() + first);
+
+    //nearest insertion: the location closest to the tour is inserted where it increases the tour cost the least
+    vector<double> dist_to_tour(remaining.size());
+    for (size_t i = 0; i < remaining.size(); i++)
+        dist_to_tour[i] = pairCost(table, m_tour[0], remaining[i]);
+
+    while (!remaining.empty())
+    {
+        size_t nearest = min_element(dist_to_tour.begin(), dist_to_tour.end()) - dist_to_tour.begin();
+        size_t node = remaining[nearest];
+        remaining.erase(remaining.begin() + nearest);
+        dist_to_tour.erase(dist_to_tour.begin() + nearest);
+
+        insertCheapest(table, node, robot_cost);
+
+        for (size_t i = 0; i < remaining.size(); i++)
+            dist_to_tour[i] = min(dist_to_tour[i], pairCost(table, node, remaining[i]));
+    }
+}
+
+/****************************************************************/
+bool TourPlanner::twoOpt(const LocationTable& table, const vector<double>& robot_cost)
+{
+    bool improved {false};
+    size_t n = m_tour.size();
+    for (size_t i = 0; i + 1 < n; i++)
+    {
+        long a = i == 0 ? -1 : (long)m_tour[i-1];
+        for (size_t j = i + 1; j < n; j++)
+        {
+            long b = (long)m_tour[i];
+            long c = (long)m_tour[j];
+            long d = j + 1 == n ? -1 : (long)m_tour[j+1];
+
+            double before = legCost(table, robot_cost, a, b) + legCost(table, robot_cost, c, d);
+            double after  = legCost(table, robot_cost, a, c) + legCost(table, robot_cost, b, d);
+            if (after < before - IMPROVEMENT_EPS)
+            {
+                reverse(m_tour.begin() + i, m_tour.begin() + j + 1);
+                improved = true;
+            }
+        }
+    }
+    return improved;
+}
+
+/****************************************************************/
+bool TourPlanner::orOpt(const LocationTable& table, const vector<double>& robot_cost)
+{
+    bool improved {false};
+    for (size_t len = 1; len <= 3; len++)
+    {
+        for (size_t i = 0; i + len <= m_tour.size(); i++)
+        {
+            size_t n = m_tour.size();
+            long prev = i == 0 ? -1 : (long)m_tour[i-1];
+            long next = i + len == n ? -1 : (long)m_tour[i+len];
+            long first = (long)m_tour[i];
+            long last = (long)m_tour[i+len-1];
+
+            double removal_gain = legCost(table, robot_cost, prev, first) + legCost(table, robot_cost, last, next) - legCost(table, robot_cost, prev, next);
+
+            vector<size_t> segment(m_tour.begin() + i, m_tour.begin() + i + len);
+            vector<size_t> rest(m_tour.begin(), m_tour.begin() + i);
+            rest.insert(rest.end(), m_tour.begin() + i + len, m_tour.end());
+
+            size_t best_pos = 0;
+            bool best_reversed {false};
+            double best_delta = numeric_limits<double>::max();
+            for (size_t p = 0; p <= rest.size(); p++)
+            {
+                if (p == i)
+                    continue; //same position
+                long x = p == 0 ? -1 : (long)rest[p-1];
+                long y = p == rest.size() ? -1 : (long)rest[p];
+                double base = legCost(table, robot_cost, x, y);
+                double fwd = legCost(table, robot_cost, x, first) + legCost(table, robot_cost, last, y) - base;
+                double rev = legCost(table, robot_cost, x, last) + legCost(table, robot_cost, first, y) - base;
+                if (fwd < best_delta) { best_delta = fwd; best_pos = p; best_reversed = false; }
+                if (rev < best_delta) { best_delta = rev; best_pos = p; best_reversed = true; }
+            }
+
+            if (best_delta < removal_gain - IMPROVEMENT_EPS)
+            {
+                if (best_reversed)
+                    reverse(segment.begin(), segment.end());
+                rest.insert(rest.begin() + best_pos, segment.begin(), segment.end());
+                m_tour = rest;
+                improved = true;
+            }
+        }
+    }
+    return improved;
+}
+
+/****************************************************************/
+void TourPlanner::improve(const LocationTable& table, const vector<double>& robot_cost)
+{
+    for (int pass = 0; pass < m_max_passes; pass++)
+    {
+        bool improved = twoOpt(table, robot_cost);
+        improved = orOpt(table, robot_cost) || improved;
+        if (!improved)
+            break;
+    }
+}
+
+/****************************************************************/
+bool TourPlanner::update(const LocationTable& table, const vector<double>& robot_cost, bool robot_moved)
+{
+    const vector<size_t>& unchecked = table.bucket(LOC_UNCHECKED);
+
+    //repair: drop the locations which are not unchecked anymore and insert the new ones
+    vector<bool> in_tour(table.size(), false);
+    size_t old_size = m_tour.size();
+    vector<size_t> kept;
+    kept.reserve(m_tour.size());
+    for (size_t id : m_tour)
+    {
+        if (id < table.size() && table.at(id).status == LOC_UNCHECKED)
+        {
+            kept.push_back(id);
+            in_tour[id] = true;
+        }
+    }
+    bool changed = kept.size() != old_size;
+    m_tour = kept;
+
+    if (m_tour.empty())
+    {
+        build(table, unchecked, robot_cost);
+        changed = true;
+    }
+    else
+    {
+        for (size_t id : unchecked)
+        {
+            if (!in_tour[id])
+            {
+                insertCheapest(table, id, robot_cost);
+                changed = true;
+            }
+        }
+    }
+
+    if (changed || robot_moved)
+        improve(table, robot_cost);
+
+    vector<double> cumulative;
+    m_tour_cost = evaluate(table, m_tour, robot_cost, cumulative);
+
+    return changed;
+}
+
+/****************************************************************/
+double TourPlanner::evaluate(const LocationTable& table, const vector<size_t>& order, const vector<double>& robot_cost, vector<double>& cumulative)
+{
+    cumulative.clear();
+    double total {0.0};
+    long prev {-1};
+    for (size_t id : order)
+    {
+        total += legCost(table, robot_cost, prev, (long)id);
+        cumulative.push_back(total);
+        prev = (long)id;
+    }
+    return total;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef TOUR_PLANNER_H
+#define TOUR_PLANNER_H
+
+#include <vector>
+#include <unordered_map>
+#include "locationTable.h"
+#include "travelCostMap.h"
+#include "mapGraph.h"
+
+using namespace std;
+
+/**
+ * Plans the order in which the unchecked locations are visited as a whole tour starting from the robot,
+ * instead of always moving to the closest location.
+ * The travel cost between two locations is computed on the global map (or as straight-line distance if the map is not available)
+ * or, for locations on different maps, through the transitions between the maps,
+ * the first time it is needed and then kept until the map changes.
+ * The tour is built with nearest insertion and improved with 2-opt and Or-opt moves. When the set of unchecked locations changes
+ * the tour is repaired (removing the locations no longer unchecked and inserting the new ones) instead of being rebuilt.
+ */
+class TourPlanner
+{
+private:
+    const TravelCostMap*                    m_cost_map;
+    const MapGraph*                         m_map_graph;
+    unordered_map<size_t, vector<float>>    m_rows;         //travel cost from a location to all the locations with lower id
+    vector<size_t>                          m_tour;
+    double                                  m_tour_cost;
+    int                                     m_max_passes;
+    double                                  m_unreachable_cost;
+    vector<int>                             m_area_of;      //area of each location, to keep the tour inside a room before moving to the next one
+    double                                  m_area_switch_cost;
+
+public:
+    TourPlanner();
+    ~TourPlanner() = default;
+
+    void    setCostMap(const TravelCostMap* cost_map);
+    void    setMapGraph(const MapGraph* map_graph);
+    void    setMaxPasses(int passes);
+    void    setUnreachableCost(double cost);
+    void    setAreas(const vector<int>& area_of, double switch_cost);
+    void    reset();
+
+    bool    update(const LocationTable& table, const vector<double>& robot_cost, bool robot_moved);
+    double  evaluate(const LocationTable& table, const vector<size_t>& order, const vector<double>& robot_cost, vector<double>& cumulative);
+
+    const vector<size_t>&   tour() const;
+    double                  tourCost() const;
+
+private:
+    double  pairCost(const LocationTable& table, size_t from, size_t to);
+    double  legCost(const LocationTable& table, const vector<double>& robot_cost, long from, long to);
+    void    build(const LocationTable& table, const vector<size_t>& nodes, const vector<double>& robot_cost);
+    void    insertCheapest(const LocationTable& table, size_t node, const vector<double>& robot_cost);
+    bool    twoOpt(const LocationTable& table, const vector<double>& robot_cost);
+    bool    orOpt(const LocationTable& table, const vector<double>& robot_cost);
+    void    improve(const LocationTable& table, const vector<double>& robot_cost);
+};
+
+#endif
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <math.h>
+#include <queue>
+#include <functional>
+#include "travelCostMap.h"
+
+const float TravelCostMap::unreachable = numeric_limits<float>::infinity();
+
+/****************************************************************/
+TravelCostMap::TravelCostMap() :
+    m_map_valid(false),
+    m_width(0),
+    m_height(0),
+    m_resolution(0.05),
+    m_field_valid(false),
+    m_recompute_cells(5),
+    m_search_radius(10)
+{
+}
+
+/****************************************************************/
+bool TravelCostMap::setMap(const MapGrid2D& map)
+{
+    m_map = map;
+    m_width = map.width();
+    m_height = map.height();
+    m_map.getResolution(m_resolution);
+    m_map_valid = (m_width > 0 && m_height > 0 && m_resolution > 0);
+    m_field_valid = false;
+    if (!m_map_valid)
+        return false;
+
+    //the cost of each cell is evaluated once, so that the field computation does not query the map
+    m_cell_cost.assign(m_width * m_height, unreachable);
+    for (size_t y = 0; y < m_height; y++)
+    {
+        for (size_t x = 0; x < m_width; x++)
+        {
+            MapGrid2D::map_flags flag;
+            if (!m_map.getMapFlag(XYCell(x, y), flag))
+                continue;
+
+            if (flag == MapGrid2D::MAP_CELL_FREE || flag == MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE || flag == MapGrid2D::MAP_CELL_GOAL)
+                m_cell_cost[y * m_width + x] = 1.0f;
+            else if (flag == MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE)
+                m_cell_cost[y * m_width + x] = 3.0f;    //reachable, but the navigation would keep away from it
+        }
+    }
+
+    //look for a reachable cell within 0.5 meters from a location
+    m_search_radius = max(1, (int)ceil(0.5 / m_resolution));
+
+    return true;
+}
+
+/****************************************************************/
+bool TravelCostMap::isValid() const
+{
+    return m_map_valid;
+}
+
+/****************************************************************/
+const MapGrid2D& TravelCostMap::getMap() const
+{
+    return m_map;
+}
+
+/****************************************************************/
+void TravelCostMap::setRecomputeThreshold(int cells)
+{
+    m_recompute_cells = max(0, cells);
+}
+
+/****************************************************************/
+void TravelCostMap::invalidate()
+{
+    m_field_valid = false;
+}
+
+/****************************************************************/
+bool TravelCostMap::toCell(const Map2DLocation& loc, XYCell& cell) const
+{
+    if (!m_map_valid)
+        return false;
+
+    XYWorld world(loc.x, loc.y);
+    if (!m_map.isInsideMap(world))
+        return false;
+
+    cell = m_map.world2Cell(world);
+    return cell.x < m_width && cell.y < m_height;
+}
+
+/****************************************************************/
+bool TravelCostMap::update(const Map2DLocation& robotLoc)
+{
+    XYCell robot_cell;
+    if (!toCell(robotLoc, robot_cell))
+    {
+        m_field_valid = false;
+        return false;
+    }
+
+    if (m_field_valid)
+    {
+        long dx = (long)robot_cell.x - (long)m_source.x;
+        long dy = (long)robot_cell.y - (long)m_source.y;
+        if (dx*dx + dy*dy <= (long)m_recompute_cells * m_recompute_cells)
+            return false;
+    }
+
+    m_source = robot_cell;
+    m_field_valid = computeField(m_source, m_field);
+    return m_field_valid;
+}
+
+/****************************************************************/
+double TravelCostMap::cost(const Map2DLocation& loc) const
+{
+    if (!m_field_valid)
+        return unreachable;
+
+    return lookup(m_field, loc);
+}
+
+/****************************************************************/
+bool TravelCostMap::computeField(const Map2DLocation& from, vector<float>& field) const
+{
+    XYCell source;
+    if (!toCell(from, source))
+        return false;
+
+    return computeField(source, field);
+}
+
+/****************************************************************/
+bool TravelCostMap::computeField(const XYCell& source, vector<float>& field) const
+{
+    if (!m_map_valid)
+        return false;
+
+    field.assign(m_width * m_height, unreachable);
+
+    typedef pair<float, size_t> node_t;
+    priority_queue<node_t, vector<node_t>, greater<node_t>> open;
+
+    //the source is seeded even if not traversable (e.g. robot close to a wall, inside the enlarged obstacles)
+    size_t source_idx = source.y * m_width + source.x;
+    field[source_idx] = 0.0f;
+    open.push(make_pair(0.0f, source_idx));
+
+    const int dx[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+    const int dy[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+    const float straight = (float)m_resolution;
+    const float diagonal = (float)(m_resolution * M_SQRT2);
+
+    while (!open.empty())
+    {
+        node_t current = open.top();
+        open.pop();
+        if (current.first > field[current.second])
+            continue;
+
+        long cx = current.second % m_width;
+        long cy = current.second / m_width;
+        for (int k = 0; k < 8; k++)
+        {
+            long nx = cx + dx[k];
+            long ny = cy + dy[k];
+            if (nx < 0 || ny < 0 || nx >= (long)m_width || ny >= (long)m_height)
+                continue;
+
+            size_t n_idx = ny * m_width + nx;
+            float cell_cost = m_cell_cost[n_idx];
+            if (std::isinf(cell_cost))
+                continue;
+
+            //diagonal moves are not allowed to cut the corners of obstacles
+            if (k >= 4 && (std::isinf(m_cell_cost[cy * m_width + nx]) || std::isinf(m_cell_cost[ny * m_width + cx])))
+                continue;
+
+            float new_cost = current.first + (k < 4 ? straight : diagonal) * cell_cost;
+            if (new_cost < field[n_idx])
+            {
+                field[n_idx] = new_cost;
+                open.push(make_pair(new_cost, n_idx));
+            }
+        }
+    }
+
+    return true;
+}
+
+/****************************************************************/
+double TravelCostMap::lookup(const vector<float>& field, const Map2DLocation& loc) const
+{
+    XYCell cell;
+    if (field.empty() || !toCell(loc, cell))
+        return unreachable;
+
+    float value = field[cell.y * m_width + cell.x];
+    if (!std::isinf(value))
+        return value;
+
+    //the location may lie on an obstacle cell (e.g. a location facing a table): use the closest reachable cell around it
+    float best = unreachable;
+    long r = m_search_radius;
+    for (long y = (long)cell.y - r; y <= (long)cell.y + r; y++)
+    {
+        if (y < 0 || y >= (long)m_height)
+            continue;
+        for (long x = (long)cell.x - r; x <= (long)cell.x + r; x++)
+        {
+            if (x < 0 || x >= (long)m_width)
+                continue;
+            float v = field[y * m_width + x];
+            if (std::isinf(v))
+                continue;
+            float d = (float)(m_resolution * sqrt((double)((x - (long)cell.x)*(x - (long)cell.x) + (y - (long)cell.y)*(y - (long)cell.y))));
+            best = min(best, v + d);
+        }
+    }
+
+    return best;
+}
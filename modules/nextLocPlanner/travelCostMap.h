@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2006-2020 Istituto Italiano di Tecnologia (IIT)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef TRAVEL_COST_MAP_H
+#define TRAVEL_COST_MAP_H
+
+#include <yarp/dev/INavigation2D.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+using namespace yarp::dev::Nav2D;
+using namespace std;
+
+/**
+ * Travel distances on the global navigation map.
+ * A distance field (Dijkstra on the 8-connected grid of the map) is computed from the cell of the robot,
+ * so that the cost of reaching any location is the length of the path around walls and not the straight-line distance.
+ * The field is recomputed only when the robot moves farther than a given number of cells from the cell it was computed from.
+ */
+class TravelCostMap
+{
+private:
+    MapGrid2D           m_map;
+    bool                m_map_valid;
+    size_t              m_width;
+    size_t              m_height;
+    double              m_resolution;
+    vector<float>       m_cell_cost;        //cost multiplier of each cell, infinity if not traversable
+
+    vector<float>       m_field;            //travel distance in meters from m_source
+    XYCell              m_source;
+    bool                m_field_valid;
+    int                 m_recompute_cells;
+    int                 m_search_radius;    //cells around a location to look for a reachable one
+
+public:
+    static const float  unreachable;
+
+    TravelCostMap();
+    ~TravelCostMap() = default;
+
+    bool            setMap(const MapGrid2D& map);
+    bool            isValid() const;
+    const MapGrid2D& getMap() const;
+    void            setRecomputeThreshold(int cells);
+    void            invalidate();
+
+    bool            update(const Map2DLocation& robotLoc);
+    double          cost(const Map2DLocation& loc) const;
+
+    bool            computeField(const Map2DLocation& from, vector<float>& field) const;
+    double          lookup(const vector<float>& field, const Map2DLocation& loc) const;
+
+private:
+    bool            toCell(const Map2DLocation& loc, XYCell& cell) const;
+    bool            computeField(const XYCell& source, vector<float>& field) const;
+};
+
+#endif
@@ -195,11 +195,14 @@ class YarpYolo(yarp.RFModule):
                 smtg = 1
         if smtg == 0:
             bout.addString('nothing')
+        self.output_coords_port.setEnvelope(self.image_stamp)
         self.output_coords_port.write()
  
 
     def updateModule(self):
         received_image = self._input_image_port.read()
+        self.image_stamp = yarp.Stamp()
+        self._input_image_port.getEnvelope(self.image_stamp)   #detections are stamped with the time of their image
         self._in_buf_image.copy(received_image)   
         assert self._in_buf_array.__array_interface__['data'][0] == self._in_buf_image.getRawImage().__int__()
         frame = self._in_buf_array